@@ -0,0 +1,44 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/*  Linked into a program, counts its heap allocations and reports the
+    total on stderr at exit as "allocations: N". The allocation test
+    builds solvesudoku with it to check that a batch allocates no more
+    for many puzzles than for a few */
+
+static std::atomic<unsigned long> allocations(0);
+
+static struct AllocReport {
+    ~AllocReport() {
+        fprintf(stderr, "allocations: %lu\n", allocations.load());
+    }
+} report;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
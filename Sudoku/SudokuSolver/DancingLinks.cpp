@@ -0,0 +1,163 @@
+#include "DancingLinks.h"
+
+template <int B>
+DancingLinks<B>::DancingLinks() : solutionDepth_(0), count_(0), limit_(1),
+                                  stats_(nullptr) {
+    for (int c = 0; c <= COLUMNS; c++) {
+        node_[c].left = (uint16_t)(c == 0 ? COLUMNS : c - 1);
+        node_[c].right = (uint16_t)(c == COLUMNS ? 0 : c + 1);
+        node_[c].up = node_[c].down = node_[c].column = (uint16_t)c;
+        node_[c].row = 0;
+        size_[c] = 0;
+    }
+    int n = COLUMNS + 1;
+    for (int cell = 0; cell < CELLS; cell++) {
+        int row = cell / N, col = cell % N;
+        int box = BasicSudokuGrid<B>::box(row, col);
+        for (int d = 0; d < N; d++) {
+            int columns[4] = {
+                1 + cell,
+                1 + CELLS + row * N + d,
+                1 + 2 * CELLS + col * N + d,
+                1 + 3 * CELLS + box * N + d
+            };
+            for (int k = 0; k < 4; k++) {
+                Node &x = node_[n + k];
+                int c = columns[k];
+                x.left = (uint16_t)(n + (k + 3) % 4);
+                x.right = (uint16_t)(n + (k + 1) % 4);
+                x.column = (uint16_t)c;
+                x.row = (uint16_t)(cell * N + d);
+                x.up = node_[c].up;       // append to bottom of column
+                x.down = (uint16_t)c;
+                node_[node_[c].up].down = (uint16_t)(n + k);
+                node_[c].up = (uint16_t)(n + k);
+                size_[c]++;
+            }
+            n += 4;
+        }
+    }
+}
+
+template <int B>
+void DancingLinks<B>::cover(int c) {
+    node_[node_[c].right].left = node_[c].left;
+    node_[node_[c].left].right = node_[c].right;
+    for (int i = node_[c].down; i != c; i = node_[i].down) {
+        for (int j = node_[i].right; j != i; j = node_[j].right) {
+            node_[node_[j].down].up = node_[j].up;
+            node_[node_[j].up].down = node_[j].down;
+            size_[node_[j].column]--;
+        }
+    }
+}
+
+template <int B>
+void DancingLinks<B>::uncover(int c) {
+    for (int i = node_[c].up; i != c; i = node_[i].up) {
+        for (int j = node_[i].left; j != i; j = node_[j].left) {
+            size_[node_[j].column]++;
+            node_[node_[j].down].up = (uint16_t)j;
+            node_[node_[j].up].down = (uint16_t)j;
+        }
+    }
+    node_[node_[c].right].left = (uint16_t)c;
+    node_[node_[c].left].right = (uint16_t)c;
+}
+
+/*  Commits to matrix row r: covers every column it satisfies */
+template <int B>
+void DancingLinks<B>::selectRow(int r) {
+    int j = r;
+    do {
+        cover(node_[j].column);
+        j = node_[j].right;
+    } while (j != r);
+}
+
+template <int B>
+void DancingLinks<B>::deselectRow(int r) {
+    int j = node_[r].left;
+    do {
+        uncover(node_[j].column);
+        j = node_[j].left;
+    } while (j != node_[r].left);
+}
+
+/*  Algorithm X; returns true once limit solutions have been counted.
+    Always unwinds its covers, even when stopping early */
+template <int B>
+bool DancingLinks<B>::search(int depth) {
+    stats_->nodes++;
+    SUDOKU_STAT_FRAME(*stats_);
+    if (node_[HEAD].right == HEAD) {
+        if (count_++ == 0) {
+            solution_ = partial_;
+            solutionDepth_ = depth;
+        }
+        return count_ >= limit_;
+    }
+    int c = node_[HEAD].right;
+    for (int j = node_[c].right; j != HEAD && size_[c] > 1; j = node_[j].right)
+        if (size_[j] < size_[c]) c = j;
+    if (size_[c] == 0)
+        return false; // some constraint can no longer be met
+
+    bool done = false;
+    cover(c);
+    for (int r = node_[c].down; r != c && !done; r = node_[r].down) {
+        partial_[depth] = node_[r].row;
+        for (int j = node_[r].right; j != r; j = node_[j].right)
+            cover(node_[j].column);
+        SUDOKU_STAT(stats_->guesses++);
+        done = search(depth + 1);
+        SUDOKU_STAT(done || stats_->backtracks++);
+        for (int j = node_[r].left; j != r; j = node_[j].left)
+            uncover(node_[j].column);
+    }
+    uncover(c);
+    return done;
+}
+
+template <int B>
+int DancingLinks<B>::solve(BasicSudokuGrid<B> &grid, SearchStats &stats,
+                           int limit) {
+    // cover the rows of the numbers already on the grid; a given whose
+    // column is already gone clashes with an earlier one
+    int givens[CELLS], numGivens = 0;
+    bool consistent = true;
+    for (int cell = 0; cell < CELLS && consistent; cell++) {
+        int n = grid.number(cell);
+        if (n == 0) continue;
+        int r = COLUMNS + 1 + 4 * (cell * N + n - 1);
+        for (int j = r; j < r + 4; j++) {
+            int c = node_[j].column;
+            if (node_[node_[c].left].right != c) consistent = false;
+        }
+        if (!consistent) break;
+        selectRow(r);
+        givens[numGivens++] = r;
+    }
+
+    count_ = 0;
+    limit_ = limit;
+    stats_ = &stats;
+    if (consistent)
+        search(0);
+    while (numGivens > 0)
+        deselectRow(givens[--numGivens]);
+
+    if (count_ > 0) {
+        for (int k = 0; k < solutionDepth_; k++) {
+            int row = solution_[k] / N / N, col = solution_[k] / N % N;
+            grid.setNumber(row, col, solution_[k] % N + 1);
+            grid.setSolved(row, col);
+        }
+    }
+    return count_;
+}
+
+template class DancingLinks<2>;
+template class DancingLinks<3>;
+template class DancingLinks<4>;
+template class DancingLinks<5>;
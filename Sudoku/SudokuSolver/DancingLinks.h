@@ -0,0 +1,58 @@
+#ifndef DANCINGLINKS_H
+#define DANCINGLINKS_H
+
+#include <array>
+#include <cstdint>
+#include "SudokuSolver.h"
+
+/*  Sudoku as an exact cover problem solved with Knuth's Algorithm X
+    using dancing links. The N^3 x 4N^2 matrix (729 x 324 for 9x9: one
+    row per cell/digit candidate; one column per cell, row/digit,
+    column/digit and box/digit constraint) is built once in the
+    constructor and every solve leaves it exactly as it found it, so one
+    object can be reused for any number of puzzles without allocating. */
+template <int B>
+class DancingLinks {
+public:
+    static constexpr int N = B * B;
+    static constexpr int CELLS = N * N;
+    static constexpr int COLUMNS = 4 * CELLS;
+    static constexpr int ROWS = N * CELLS;
+
+    DancingLinks();
+
+    /*  Solves grid in place (first solution found) and returns the
+        number of solutions, counting no further than limit */
+    int solve(BasicSudokuGrid<B> &grid, SearchStats &stats, int limit = 1);
+
+private:
+    // 16-bit links keep a node in 12 bytes, and the four nodes of a
+    // matrix row are adjacent: walking a row reads 48 contiguous bytes
+    // (nodes are not aligned, so that may touch two cache lines)
+    struct Node {
+        uint16_t left, right, up, down;
+        uint16_t column;  // header index
+        uint16_t row;     // candidate index: cell * N + digit - 1
+    };
+    static_assert(sizeof(Node) == 12, "a node is six 16-bit fields");
+    static constexpr int HEAD = 0;
+    static constexpr int NODES = 1 + COLUMNS + 4 * ROWS;
+    static_assert(NODES <= 65536, "links must fit in 16 bits");
+
+    std::array<Node, NODES> node_;
+    std::array<uint16_t, COLUMNS + 1> size_;
+    std::array<uint16_t, CELLS> partial_;   // rows chosen on the current path
+    std::array<uint16_t, CELLS> solution_;  // rows of the first solution
+    int solutionDepth_;
+    int count_;
+    int limit_;
+    SearchStats *stats_;
+
+    void cover(int c);
+    void uncover(int c);
+    void selectRow(int r);
+    void deselectRow(int r);
+    bool search(int depth);
+};
+
+#endif // DANCINGLINKS_H
@@ -0,0 +1,215 @@
+#include "SudokuSolver.h"
+
+/*  The elimination passes of deduce(). They work on the pencil marks
+    alone (which must hold the candidates of every empty cell) and never
+    place a digit themselves; placing the singles they open up is left
+    to propagateUnits */
+
+const char *const DEDUCE_PASS_NAMES[DEDUCE_PASSES] = {
+    "locked", "naked", "hidden", "xwing"
+};
+
+/*  Strikes mask from the pencils of cell k, queueing its units if that
+    changed anything; returns the number of marks struck */
+template <int B>
+static int strike(BasicSudokuGrid<B> &grid, int k,
+                  typename BasicSudokuGrid<B>::Mask mask, DirtyUnits<B> &dirty) {
+    typedef BasicSudokuGrid<B> Grid;
+    typename Grid::Mask p = grid.pencils(k), gone = p & mask;
+    if (!gone) return 0;
+    grid.setPencils(k, p & (typename Grid::Mask)~gone);
+    dirty.touch(k);
+    return Grid::countDigits(gone);
+}
+
+/*  A digit whose marks in a box all lie in one row (or column) must go
+    in that box, so it can come out of the rest of the row (pointing).
+    Likewise a digit confined to one box within a row or column can
+    come out of the rest of the box (claiming) */
+template <int B>
+int lockedCandidates(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename Grid::Mask Mask;
+    const int N = Grid::N;
+    const SudokuTables<B> &T = Grid::tables;
+    int struck = 0;
+    for (int b = 0; b < N; b++) {
+        // box cells run row-major within the box: index i is at box
+        // row i / B and box column i % B
+        const uint16_t *cells = T.unitCells[2 * N + b];
+        Mask rows[B] = {}, cols[B] = {};
+        for (int i = 0; i < N; i++) {
+            rows[i / B] |= grid.pencils(cells[i]);
+            cols[i % B] |= grid.pencils(cells[i]);
+        }
+        for (int j = 0; j < B; j++) {
+            Mask rowOnly = rows[j], colOnly = cols[j];
+            for (int o = 0; o < B; o++) {
+                if (o == j) continue;
+                rowOnly &= (Mask)~rows[o];
+                colOnly &= (Mask)~cols[o];
+            }
+            if (rowOnly) {
+                int row = T.cellRow[cells[j * B]];
+                for (int k : T.unitCells[row])
+                    if (T.cellBox[k] != b) struck += strike(grid, k, rowOnly, dirty);
+            }
+            if (colOnly) {
+                int col = T.cellCol[cells[j]];
+                for (int k : T.unitCells[N + col])
+                    if (T.cellBox[k] != b) struck += strike(grid, k, colOnly, dirty);
+            }
+        }
+    }
+    for (int u = 0; u < 2 * N; u++) {
+        // a row or column crosses B boxes, B cells each
+        const uint16_t *cells = T.unitCells[u];
+        Mask segs[B] = {};
+        for (int i = 0; i < N; i++)
+            segs[i / B] |= grid.pencils(cells[i]);
+        for (int j = 0; j < B; j++) {
+            Mask only = segs[j];
+            for (int o = 0; o < B; o++)
+                if (o != j) only &= (Mask)~segs[o];
+            if (!only) continue;
+            int box = T.cellBox[cells[j * B]];
+            for (int k : T.unitCells[2 * N + box]) {
+                bool inLine = u < N ? T.cellRow[k] == u : T.cellCol[k] == u - N;
+                if (!inLine) struck += strike(grid, k, only, dirty);
+            }
+        }
+    }
+    return struck;
+}
+
+/*  Two cells of a unit with the same two marks between them (or three
+    cells with three) hold those digits, so no other cell of the unit
+    can */
+template <int B>
+int nakedSubsets(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename Grid::Mask Mask;
+    const int N = Grid::N;
+    const SudokuTables<B> &T = Grid::tables;
+    int struck = 0;
+    for (int u = 0; u < 3 * N; u++) {
+        const uint16_t *cells = T.unitCells[u];
+        int small[N], n = 0;  // unit indices of cells with 2 or 3 marks
+        for (int i = 0; i < N; i++) {
+            int c = Grid::countDigits(grid.pencils(cells[i]));
+            if (grid.number(cells[i]) == 0 && c >= 2 && c <= 3) small[n++] = i;
+        }
+        for (int a = 0; a < n; a++) {
+            for (int b = a + 1; b < n; b++) {
+                Mask pair = grid.pencils(cells[small[a]]) | grid.pencils(cells[small[b]]);
+                if (Grid::countDigits(pair) == 2) {
+                    for (int i = 0; i < N; i++)
+                        if (i != small[a] && i != small[b] && grid.number(cells[i]) == 0)
+                            struck += strike(grid, cells[i], pair, dirty);
+                }
+                for (int c = b + 1; c < n; c++) {
+                    Mask triple = pair | grid.pencils(cells[small[c]]);
+                    if (Grid::countDigits(triple) != 3) continue;
+                    for (int i = 0; i < N; i++)
+                        if (i != small[a] && i != small[b] && i != small[c] &&
+                            grid.number(cells[i]) == 0)
+                            struck += strike(grid, cells[i], triple, dirty);
+                }
+            }
+        }
+    }
+    return struck;
+}
+
+/*  Two digits whose marks in a unit all fall in the same two cells (or
+    three in three) must fill those cells, so any other marks there go */
+template <int B>
+int hiddenSubsets(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename Grid::Mask Mask;
+    const int N = Grid::N;
+    const SudokuTables<B> &T = Grid::tables;
+    int struck = 0;
+    for (int u = 0; u < 3 * N; u++) {
+        const uint16_t *cells = T.unitCells[u];
+        uint32_t where[N] = {};  // bit i: digit d + 1 is marked in cells[i]
+        for (int i = 0; i < N; i++) {
+            Mask p = grid.pencils(cells[i]);
+            for (; p; p &= p - 1)
+                where[Grid::lowestDigit(p) - 1] |= 1u << i;
+        }
+        int few[N], n = 0;  // digits marked in 2 or 3 cells
+        for (int d = 0; d < N; d++) {
+            int c = __builtin_popcount(where[d]);
+            if (c >= 2 && c <= 3) few[n++] = d;
+        }
+        for (int a = 0; a < n; a++) {
+            for (int b = a + 1; b < n; b++) {
+                uint32_t pair = where[few[a]] | where[few[b]];
+                Mask keep = (Mask)(Grid::digitBit(few[a] + 1) | Grid::digitBit(few[b] + 1));
+                if (__builtin_popcount(pair) == 2) {
+                    for (uint32_t w = pair; w; w &= w - 1)
+                        struck += strike(grid, cells[__builtin_ctz(w)], (Mask)~keep, dirty);
+                }
+                for (int c = b + 1; c < n; c++) {
+                    uint32_t triple = pair | where[few[c]];
+                    if (__builtin_popcount(triple) != 3) continue;
+                    Mask keep3 = (Mask)(keep | Grid::digitBit(few[c] + 1));
+                    for (uint32_t w = triple; w; w &= w - 1)
+                        struck += strike(grid, cells[__builtin_ctz(w)], (Mask)~keep3, dirty);
+                }
+            }
+        }
+    }
+    return struck;
+}
+
+/*  A digit with exactly two marks in each of two rows, in the same two
+    columns, takes one corner of that rectangle per row and so one per
+    column: it can come out of the rest of both columns. The same goes
+    with rows and columns swapped */
+template <int B>
+int xWing(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename Grid::Mask Mask;
+    const int N = Grid::N;
+    const SudokuTables<B> &T = Grid::tables;
+    int struck = 0;
+    for (int d = 1; d <= N; d++) {
+        Mask bit = Grid::digitBit(d);
+        // lines 0..N-1 are rows (positions are columns), N..2N-1 columns
+        for (int base = 0; base < 2 * N; base += N) {
+            uint32_t where[N];
+            for (int l = 0; l < N; l++) {
+                where[l] = 0;
+                const uint16_t *cells = T.unitCells[base + l];
+                for (int i = 0; i < N; i++)
+                    if (grid.pencils(cells[i]) & bit) where[l] |= 1u << i;
+            }
+            for (int a = 0; a < N; a++) {
+                if (__builtin_popcount(where[a]) != 2) continue;
+                for (int b = a + 1; b < N; b++) {
+                    if (where[b] != where[a]) continue;
+                    for (uint32_t w = where[a]; w; w &= w - 1) {
+                        // the crossing line: a column for rows and back
+                        const uint16_t *cross = T.unitCells[(N - base) + __builtin_ctz(w)];
+                        for (int l = 0; l < N; l++)
+                            if (l != a && l != b) struck += strike(grid, cross[l], bit, dirty);
+                    }
+                }
+            }
+        }
+    }
+    return struck;
+}
+
+#define INSTANTIATE_DEDUCTIONS(B) \
+    template int lockedCandidates(BasicSudokuGrid<B> &, DirtyUnits<B> &); \
+    template int nakedSubsets(BasicSudokuGrid<B> &, DirtyUnits<B> &); \
+    template int hiddenSubsets(BasicSudokuGrid<B> &, DirtyUnits<B> &); \
+    template int xWing(BasicSudokuGrid<B> &, DirtyUnits<B> &);
+
+INSTANTIATE_DEDUCTIONS(2)
+INSTANTIATE_DEDUCTIONS(3)
+INSTANTIATE_DEDUCTIONS(4)
+INSTANTIATE_DEDUCTIONS(5)
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include "IterativeSearch.h"
+
+template <int B>
+IterativeSearch<B>::IterativeSearch(const Grid &grid, Branching branching)
+    : grid_(grid), branching_(branching), depth_(0), visit_(true) {}
+
+/*  The cell to branch on at the current node, false if the grid is
+    full. With first-empty branching every cell before the top frame's
+    is filled, so the scan starts just past it */
+template <int B>
+bool IterativeSearch<B>::nextCell(int &k, SearchStats &stats) {
+    if (branching_ == Branching::FewestCandidates) {
+        int row, col;
+        if (!findFewestCandidates(grid_, row, col, &stats))
+            return false;
+        k = Grid::cell(row, col);
+        return true;
+    }
+    for (k = depth_ > 0 ? stack_[depth_ - 1].cell + 1 : 0; k < Grid::CELLS; k++)
+        if (grid_.number(k) == 0)
+            return true;
+    return false;
+}
+
+template <int B>
+typename IterativeSearch<B>::Status
+IterativeSearch<B>::run(SearchStats &stats, unsigned long budget) {
+    const SudokuTables<B> &T = Grid::tables;
+    // work on locals: stores to the grid's bytes could alias members,
+    // which would keep the compiler from holding these in registers
+    int depth = depth_;
+    bool visit = visit_;
+    unsigned long visited = 0;
+    Status status;
+    for (;;) {
+        if (visit) {
+            if (budget != 0 && visited == budget) {
+                status = Status::Paused;
+                break;
+            }
+            visited++;
+            stats.nodes++;
+            SUDOKU_STAT(stats.maxDepth = std::max(stats.maxDepth, depth + 1));
+            int k;
+            depth_ = depth;
+            if (!nextCell(k, stats)) {
+                visit = false; // a later run() backtracks from here
+                status = Status::Solved;
+                break;
+            }
+            SUDOKU_STAT(stats.checks++);
+            stack_[depth++] = Frame{(uint16_t)k, grid_.candidates(k)};
+        } else {
+            if (depth == 0) {
+                status = Status::Exhausted;
+                break;
+            }
+            SUDOKU_STAT(stats.backtracks++); // back from a failed guess
+        }
+        Frame &f = stack_[depth - 1];
+        int row = T.cellRow[f.cell], col = T.cellCol[f.cell];
+        if (f.cands == 0) {
+            grid_.setNumber(row, col, 0); // out of candidates, pop
+            depth--;
+            visit = false;
+            continue;
+        }
+        SUDOKU_STAT(stats.guesses++);
+        grid_.setNumber(row, col, Grid::lowestDigit(f.cands));
+        f.cands &= f.cands - 1;
+        visit = true;
+    }
+    depth_ = depth;
+    visit_ = visit;
+    return status;
+}
+
+template <int B>
+bool IterativeSearch<B>::split(Grid &part) {
+    const SudokuTables<B> &T = Grid::tables;
+    int i = 0;
+    while (i < depth_ && stack_[i].cands == 0) i++;
+    if (i == depth_)
+        return false;
+    // the part keeps the guesses below frame i and takes the next
+    // candidate at it; everything deeper is still this search's
+    part = grid_;
+    for (int j = i + 1; j < depth_; j++)
+        part.setNumber(T.cellRow[stack_[j].cell], T.cellCol[stack_[j].cell], 0);
+    Frame &f = stack_[i];
+    part.setNumber(T.cellRow[f.cell], T.cellCol[f.cell], Grid::lowestDigit(f.cands));
+    f.cands &= f.cands - 1;
+    return true;
+}
+
+template <int B>
+bool solveIterative(BasicSudokuGrid<B> &grid, Branching branching,
+                    SearchStats &stats) {
+    IterativeSearch<B> search(grid, branching);
+    if (search.run(stats) != IterativeSearch<B>::Status::Solved)
+        return false;
+    grid = search.grid();
+    return true;
+}
+
+#define INSTANTIATE_ITERATIVE(B) \
+    template class IterativeSearch<B>; \
+    template bool solveIterative(BasicSudokuGrid<B> &, Branching, SearchStats &);
+
+INSTANTIATE_ITERATIVE(2)
+INSTANTIATE_ITERATIVE(3)
+INSTANTIATE_ITERATIVE(4)
+INSTANTIATE_ITERATIVE(5)
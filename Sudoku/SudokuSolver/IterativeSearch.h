@@ -0,0 +1,61 @@
+#ifndef ITERATIVESEARCH_H
+#define ITERATIVESEARCH_H
+
+#include <array>
+#include <cstdint>
+#include "SudokuSolver.h"
+
+/*  The backtracking search of solveSudoku run as a loop over an
+    explicit stack of (cell, untried candidates) frames instead of
+    recursion. The object holds the whole search state (its own copy of
+    the grid plus at most one frame per cell, all preallocated), so a
+    search can stop after a node budget and carry on later, be copied
+    as a snapshot, or give away untried branches to another thread.
+    It visits the same nodes in the same order as solveSudoku. */
+template <int B>
+class IterativeSearch {
+public:
+    typedef BasicSudokuGrid<B> Grid;
+
+    enum class Status {
+        Solved,     // grid() is a solution; run() again for the next one
+        Exhausted,  // no (more) solutions
+        Paused      // node budget used up; run() again to carry on
+    };
+
+    IterativeSearch(const Grid &grid, Branching branching);
+
+    /*  Searches for up to budget nodes (0: no limit) */
+    Status run(SearchStats &stats, unsigned long budget = 0);
+
+    /*  Hands the next untried candidate of the shallowest open frame
+        to part, as a grid to be searched on its own, and drops it from
+        this search; false if there is nothing left to give away */
+    bool split(Grid &part);
+
+    const Grid &grid() const { return grid_; }
+    int depth() const { return depth_; }
+
+private:
+    struct Frame {
+        uint16_t cell;
+        typename Grid::Mask cands;  // not yet tried
+    };
+
+    Grid grid_;
+    Branching branching_;
+    std::array<Frame, Grid::CELLS> stack_;
+    int depth_;
+    bool visit_;  // next step visits the node at grid_ instead of
+                  // trying the top frame's next candidate
+
+    bool nextCell(int &k, SearchStats &stats);
+};
+
+/*  Solves grid in place with an IterativeSearch run to the end, as
+    solveSudoku does recursively */
+template <int B>
+bool solveIterative(BasicSudokuGrid<B> &grid, Branching branching,
+                    SearchStats &stats);
+
+#endif // ITERATIVESEARCH_H
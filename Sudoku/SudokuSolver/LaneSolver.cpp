@@ -0,0 +1,157 @@
+#include <cstdlib>
+#include <cstring>
+#include "LaneSolver.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LANES_X86 1
+#endif
+
+template <int B>
+void LaneSolver<B>::clear() {
+    for (auto &cell : cand_)
+        for (Mask &lane : cell)
+            lane = Grid::ALL_DIGITS;
+}
+
+template <int B>
+void LaneSolver<B>::load(int lane, const Grid &grid) {
+    for (int k = 0; k < Grid::CELLS; k++) {
+        int n = grid.number(k);
+        cand_[k][lane] = n ? Grid::digitBit(n) : Grid::ALL_DIGITS;
+    }
+}
+
+template <int B>
+void LaneSolver<B>::store(int lane, Grid &grid) const {
+    for (int k = 0; k < Grid::CELLS; k++)
+        if (grid.number(k) == 0)
+            grid.setNumber(k / Grid::N, k % Grid::N, Grid::lowestDigit(cand_[k][lane]));
+}
+
+namespace {
+
+template <int B>
+using LaneKernel = unsigned (*)(typename BasicSudokuGrid<B>::Mask (*)[16]);
+
+/*  The propagation loop, inlined into one copy per instruction set.
+    Masks are all-ones lanes for true, as vector comparisons give */
+template <int B, class Vec>
+__attribute__((always_inline))
+inline unsigned propagateLanes(Vec *cand) {
+    typedef BasicSudokuGrid<B> Grid;
+    const int N = Grid::N, LANES = sizeof(Vec) / sizeof(cand[0][0]);
+    const SudokuTables<B> &T = Grid::tables;
+    const Vec all = Vec{} + Grid::ALL_DIGITS;
+    Vec bad{};  // lanes that hit a contradiction
+    for (;;) {
+        // each unit works on the cells as the units before it left
+        // them, so a digit placed early in a pass is struck from the
+        // rest of the grid in the same pass
+        Vec changed{};
+        for (int u = 0; u < 3 * N; u++) {
+            const uint16_t *cells = T.unitCells[u];
+            Vec placed{};
+            for (int i = 0; i < N; i++) {
+                Vec c = cand[cells[i]];
+                Vec single = c & (Vec)((c & (c - 1)) == 0);
+                bad |= (Vec)((placed & single) != 0);  // one digit twice
+                placed |= single;
+            }
+            // naked singles: the placed digits leave the open cells
+            Vec once{}, twice{};
+            for (int i = 0; i < N; i++) {
+                Vec c = cand[cells[i]];
+                Vec n = c & ~(placed & (Vec)((c & (c - 1)) != 0));
+                bad |= (Vec)(n == 0);
+                changed |= n ^ c;
+                cand[cells[i]] = n;
+                twice |= once & n;
+                once |= n;
+            }
+            bad |= (Vec)(once != all);  // a digit with nowhere to go
+            // hidden singles: a digit left in one cell only goes there
+            Vec hidden = once & ~twice;
+            for (int i = 0; i < N; i++) {
+                Vec c = cand[cells[i]];
+                Vec h = c & hidden;
+                Vec n = h | (c & (Vec)(h == 0));
+                changed |= n ^ c;
+                cand[cells[i]] = n;
+            }
+        }
+        bool going = false;
+        for (int l = 0; l < LANES; l++)
+            going |= changed[l] != 0 && bad[l] == 0;
+        if (!going) break;
+    }
+    Vec full = ~bad;
+    for (int k = 0; k < Grid::CELLS; k++)
+        full &= (Vec)((cand[k] & (cand[k] - 1)) == 0);
+    unsigned solved = 0;
+    for (int l = 0; l < LANES; l++)
+        if (full[l]) solved |= 1u << l;
+    return solved;
+}
+
+/*  Propagates all LANES lanes, as many at a time as one Vec holds */
+template <int B, class Vec>
+__attribute__((always_inline))
+inline unsigned propagateGroups(typename BasicSudokuGrid<B>::Mask (*lanes)[16]) {
+    typedef BasicSudokuGrid<B> Grid;
+    const int WIDTH = sizeof(Vec) / sizeof(lanes[0][0]);
+    unsigned solved = 0;
+    for (int first = 0; first < LaneSolver<B>::LANES; first += WIDTH) {
+        Vec cand[Grid::CELLS];
+        for (int k = 0; k < Grid::CELLS; k++)
+            memcpy(&cand[k], &lanes[k][first], sizeof(Vec));
+        solved |= propagateLanes<B>(cand) << first;
+        for (int k = 0; k < Grid::CELLS; k++)
+            memcpy(&lanes[k][first], &cand[k], sizeof(Vec));
+    }
+    return solved;
+}
+
+template <int B>
+static unsigned propagate128(typename BasicSudokuGrid<B>::Mask (*lanes)[16]) {
+    typedef typename BasicSudokuGrid<B>::Mask Vec __attribute__((vector_size(16)));
+    return propagateGroups<B, Vec>(lanes);
+}
+
+#ifdef LANES_X86
+/*  The same with all 16 lanes of 16-bit masks in one register. Vector
+    comparisons wider than the target's registers would be split up
+    lane by lane, so this is only worth it compiled for AVX2 */
+template <int B>
+__attribute__((target("avx2")))
+static unsigned propagate256(typename BasicSudokuGrid<B>::Mask (*lanes)[16]) {
+    typedef typename BasicSudokuGrid<B>::Mask Vec __attribute__((vector_size(32)));
+    return propagateGroups<B, Vec>(lanes);
+}
+#endif
+
+/*  AVX2 if this CPU has it, unless SUDOKU_LANES is "sse2" */
+template <int B>
+static LaneKernel<B> selectLaneKernel() {
+#ifdef LANES_X86
+    const char *want = getenv("SUDOKU_LANES");
+    if ((want == nullptr || strcmp(want, "sse2") != 0) && __builtin_cpu_supports("avx2"))
+        return propagate256<B>;
+#endif
+    return propagate128<B>;
+}
+
+} // namespace
+
+template <int B>
+unsigned LaneSolver<B>::run() {
+    static const LaneKernel<B> kernel = selectLaneKernel<B>();
+    return kernel(cand_);
+}
+
+#define INSTANTIATE_LANES(B) \
+    template class LaneSolver<B>;
+
+INSTANTIATE_LANES(2)
+INSTANTIATE_LANES(3)
+INSTANTIATE_LANES(4)
+INSTANTIATE_LANES(5)
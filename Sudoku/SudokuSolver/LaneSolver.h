@@ -0,0 +1,40 @@
+#ifndef LANESOLVER_H
+#define LANESOLVER_H
+
+#include "SudokuSolver.h"
+
+/*  Singles propagation on LANES puzzles at once, for batches of easy
+    puzzles. Each cell's candidate masks for all the puzzles sit side by
+    side in one vector (GCC vector extensions: 16 x 16 bits for boards
+    of up to 16 digits, one AVX2 register), and every pass runs the same
+    instructions over all of them with no branches per puzzle: strike
+    the digits already placed in a cell's units (naked singles), then
+    narrow a cell to the digit only it can take in a unit (hidden
+    singles), until no lane changes. A puzzle that comes out full was
+    forced digit by digit, so its solution is the only one; the others
+    are left to a search. */
+template <int B>
+class LaneSolver {
+public:
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename Grid::Mask Mask;
+    static constexpr int LANES = 16;
+
+    LaneSolver() { clear(); }
+
+    /*  Empties every lane; an empty lane never comes out solved */
+    void clear();
+    void load(int lane, const Grid &grid);
+
+    /*  Propagates all the lanes as far as singles go; returns a bit mask
+        of the lanes that came out full and consistent */
+    unsigned run();
+
+    /*  Fills the empty cells of grid in from lane, after run() */
+    void store(int lane, Grid &grid) const;
+
+private:
+    Mask cand_[Grid::CELLS][LANES];
+};
+
+#endif // LANESOLVER_H
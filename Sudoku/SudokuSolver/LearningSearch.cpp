@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <utility>
+#include "LearningSearch.h"
+
+using namespace std;
+
+namespace {
+
+/*  SplitMix64: seeds the Zobrist keys and the digit shuffles */
+inline uint64_t nextRandom(uint64_t &state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/*  A random 64-bit key per (cell, digit); a grid state hashes to the
+    XOR of the keys of its placed digits */
+template <int B>
+struct ZobristKeys {
+    typedef BasicSudokuGrid<B> Grid;
+    uint64_t key[Grid::CELLS][Grid::N];
+    ZobristKeys() {
+        uint64_t seed = 0x5d0c0ull + B;
+        for (auto &cell : key)
+            for (uint64_t &k : cell)
+                k = nextRandom(seed);
+    }
+};
+
+template <int B>
+const ZobristKeys<B> &zobristKeys() {
+    static const ZobristKeys<B> keys;
+    return keys;
+}
+
+/*  The i'th term (from 0) of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ... */
+unsigned long luby(unsigned long i) {
+    unsigned long size = 1, seq = 0;
+    while (size < i + 1) {
+        seq++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) >> 1;
+        seq--;
+        i %= size;
+    }
+    return 1ul << seq;
+}
+
+} // namespace
+
+template <int B>
+bool LearningSearch<B>::solve(Grid &grid, Branching branching, SearchStats &stats) {
+    if (!consistentGivens(grid))
+        return false;
+    const ZobristKeys<B> &keys = zobristKeys<B>();
+    if (nogoods_.empty())
+        nogoods_.assign(size_t(1) << TABLE_BITS, Nogood{0, 0, 0});
+    solves_++;
+    branching_ = branching;
+    salt_ = nextRandom(salt_);
+    uint64_t hash = 0;
+    for (int k = 0; k < Grid::CELLS; k++)
+        if (grid.number(k) != 0)
+            hash ^= keys.key[k][grid.number(k) - 1];
+    // the same puzzle gets the same digit orders every time
+    rng_ = hash;
+    guessed_.reset();
+    for (unsigned long run = 0;; run++) {
+        budget_ = luby(run) * RESTART_UNIT;
+        Cells conflict;
+        Result result = search(grid, hash, 1, conflict, stats);
+        if (result != Result::Restart)
+            return result == Result::Solved;
+        restarts_++;
+    }
+}
+
+template <int B>
+bool LearningSearch<B>::fail() {
+    return budget_ == 0 || --budget_ == 0;
+}
+
+/*  Adds to conflict the guessed cells that rule digits out of cell k:
+    for each digit a peer holds, the earliest guess holding it, or none
+    if a given (or a cell deduced before the search) holds it */
+template <int B>
+void LearningSearch<B>::addReasons(const Grid &grid, int k, Cells &conflict) const {
+    const int N = Grid::N;
+    typename Grid::Mask fixed = 0;
+    int culprit[N + 1];
+    for (int n = 1; n <= N; n++)
+        culprit[n] = -1;
+    for (int p : Grid::tables.peers[k]) {
+        int n = grid.number(p);
+        if (n == 0) continue;
+        if (!guessed_[p])
+            fixed |= Grid::digitBit(n);
+        else if (culprit[n] < 0 || depth_[p] < depth_[culprit[n]])
+            culprit[n] = p;
+    }
+    for (int n = 1; n <= N; n++)
+        if (culprit[n] >= 0 && !(fixed & Grid::digitBit(n)))
+            conflict.set(culprit[n]);
+}
+
+/*  One node: Failed leaves in conflict the guessed cells behind the
+    failure */
+template <int B>
+typename LearningSearch<B>::Result
+LearningSearch<B>::search(Grid &grid, uint64_t hash, int depth, Cells &conflict,
+                          SearchStats &stats) {
+    const ZobristKeys<B> &keys = zobristKeys<B>();
+    const uint64_t mask = (uint64_t(1) << TABLE_BITS) - 1;
+    stats.nodes++;
+    SUDOKU_STAT_FRAME(stats);
+    Nogood *pair = &nogoods_[hash & mask & ~uint64_t(1)];
+    uint64_t key = hash ^ salt_;
+    unsigned long start = stats.nodes;
+    if (pair[0].key == key || pair[1].key == key) {
+        // why this state failed is not kept, so blame every guess
+        pruned_++;
+        conflict = guessed_;
+        return fail() ? Result::Restart : Result::Failed;
+    }
+    int row, col;
+    bool found = branching_ == Branching::FewestCandidates ?
+        findFewestCandidates(grid, row, col, &stats) :
+        findUnassignedLocation(grid, row, col);
+    if (!found)
+        return Result::Solved;
+    SUDOKU_STAT(stats.checks++);
+    typename Grid::Mask cands = grid.candidates(row, col);
+    // this run's digit order for the cell: a Fisher-Yates shuffle
+    int digits[Grid::N], n = 0;
+    for (; cands; cands &= cands - 1)
+        digits[n++] = Grid::lowestDigit(cands);
+    for (int i = n - 1; i > 0; i--)
+        swap(digits[i], digits[nextRandom(rng_) % (i + 1)]);
+    int k = Grid::cell(row, col);
+    Cells blame;
+    bool jumped = false;
+    for (int i = 0; i < n && !jumped; i++) {
+        SUDOKU_STAT(stats.guesses++);
+        grid.setNumber(row, col, digits[i]);
+        guessed_.set(k);
+        depth_[k] = (uint16_t)depth;
+        Cells why;
+        Result result = search(grid, hash ^ keys.key[k][digits[i] - 1], depth + 1,
+                               why, stats);
+        if (result == Result::Solved)
+            return result;
+        SUDOKU_STAT(stats.backtracks++);
+        grid.setNumber(row, col, 0);
+        guessed_.reset(k);
+        if (result == Result::Restart)
+            return result;
+        // a failure that does not depend on this cell fails every digit
+        // here: jump back over it
+        jumped = !why[k];
+        if (jumped)
+            blame = why;
+        else
+            blame |= why;
+    }
+    if (!jumped) {
+        // the digits never tried were ruled out by peers
+        addReasons(grid, k, blame);
+        blame.reset(k);
+    }
+    conflict = blame;
+    // whichever way it failed, no path need ever search this state again
+    if (n > 0) {
+        // keep the one of the pair that took more work to refute
+        uint32_t work = (uint32_t)min<unsigned long>(stats.nodes - start, UINT32_MAX);
+        Nogood &old = pair[pair[0].solve != solves_ ? 0 :
+                           pair[1].solve != solves_ ? 1 :
+                           pair[0].work <= pair[1].work ? 0 : 1];
+        old = Nogood{key, work, solves_};
+    }
+    return fail() ? Result::Restart : Result::Failed;
+}
+
+template <int B>
+bool solveLearning(BasicSudokuGrid<B> &grid, Branching branching,
+                   SearchStats &stats) {
+    LearningSearch<B> search;
+    return search.solve(grid, branching, stats);
+}
+
+#define INSTANTIATE_LEARNING(B) \
+    template class LearningSearch<B>; \
+    template bool solveLearning(BasicSudokuGrid<B> &, Branching, SearchStats &);
+
+INSTANTIATE_LEARNING(2)
+INSTANTIATE_LEARNING(3)
+INSTANTIATE_LEARNING(4)
+INSTANTIATE_LEARNING(5)
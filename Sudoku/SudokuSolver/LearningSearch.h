@@ -0,0 +1,84 @@
+#ifndef LEARNINGSEARCH_H
+#define LEARNINGSEARCH_H
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+#include "SudokuSolver.h"
+
+/*  The backtracking search of solveSudoku with conflict-directed
+    backjumping, restarts and learned nogoods, for the few puzzles whose
+    search tree blows up under chronological backtracking.
+
+    A failed branch reports its conflict set: the guessed cells that
+    caused it, found from the peers that rule out each digit of a cell
+    left with none to try. If that set misses the cell the search is
+    branching on, no other digit there can help either, so the search
+    jumps straight back past it instead of trying them all.
+
+    Every restart tries digits in a new random order.
+    A restart comes after a budget of failed branches that follows the
+    Luby sequence (1 1 2 1 1 2 4 1 1 2 ...) times RESTART_UNIT. What
+    carries over is the nogood table: a bounded hash set of grid states
+    (the digits placed, givens included, as a Zobrist hash) whose every
+    branch has failed. A later visit to one of them, in any run and
+    reached by any path, fails on the spot, so restarts give up none of
+    the work already done. Only a clash of 64-bit hashes could prune a
+    live branch. A nogood is a whole state, so nothing learned bounds
+    the search on givens that clash: solve refuses those up front. Each hash has a pair of
+    slots; when both are taken the state that cost fewer nodes to refute
+    gives way.
+
+    The table is kept from one solve to the next, so a batch allocates
+    it once. Each solve salts its hashes, which makes the last solve's
+    entries noise that never matches: emptying the table costs
+    nothing. */
+template <int B>
+class LearningSearch {
+public:
+    typedef BasicSudokuGrid<B> Grid;
+
+    static const int TABLE_BITS = 16;                // nogoods kept, as a power of 2
+    static const unsigned long RESTART_UNIT = 1024;  // failures per Luby step
+
+    LearningSearch() : branching_(Branching::FirstEmpty), salt_(0), solves_(0),
+                       rng_(0), budget_(0), restarts_(0), pruned_(0) {}
+
+    /*  Solves grid in place; false if it has no solution, at once if
+        its givens clash */
+    bool solve(Grid &grid, Branching branching, SearchStats &stats);
+
+    unsigned long restarts() const { return restarts_; }  // in all solves so far
+    unsigned long pruned() const { return pruned_; }      // branches cut by nogoods
+
+private:
+    enum class Result { Solved, Failed, Restart };
+    typedef std::bitset<Grid::CELLS> Cells;
+
+    Branching branching_;
+    struct Nogood {
+        uint64_t key;     // salted hash of the state
+        uint32_t work;    // nodes it took to refute
+        uint32_t solve;   // which solve stored it
+    };
+    std::vector<Nogood> nogoods_;  // pairs of slots picked by the low hash bits
+    uint64_t salt_;     // this solve's
+    uint32_t solves_;   // solves so far: entries from older ones are free slots
+    uint64_t rng_;
+    unsigned long budget_;  // failures left before the next restart
+    unsigned long restarts_, pruned_;
+    Cells guessed_;                // cells the search has filled in
+    uint16_t depth_[Grid::CELLS];  // and at which guess, from 1
+
+    Result search(Grid &grid, uint64_t hash, int depth, Cells &conflict,
+                  SearchStats &stats);
+    void addReasons(const Grid &grid, int k, Cells &conflict) const;
+    bool fail();  // charges a failure; true when it is time to restart
+};
+
+/*  Solves grid in place with a LearningSearch of its own */
+template <int B>
+bool solveLearning(BasicSudokuGrid<B> &grid, Branching branching,
+                   SearchStats &stats);
+
+#endif // LEARNINGSEARCH_H
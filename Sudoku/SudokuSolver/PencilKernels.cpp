@@ -0,0 +1,135 @@
+#include <cstdlib>
+#include <cstring>
+#include "SudokuGrid.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define PENCIL_X86 1
+#include <immintrin.h>
+#endif
+
+/*  Every kernel computes, for all 81 cells at once,
+        pencil = ~(rowUsed | colUsed | boxUsed) & ALL_DIGITS
+    for empty cells and 0 for filled ones. They differ only in how
+    many cells go through each instruction. */
+typedef void (*PencilKernel)(const uint16_t *rowUsed, const uint16_t *colUsed,
+                             const uint16_t *boxUsed, const uint8_t *value,
+                             uint16_t *pencil);
+
+static void pencilScalar(const uint16_t *rowUsed, const uint16_t *colUsed,
+                         const uint16_t *boxUsed, const uint8_t *value,
+                         uint16_t *pencil) {
+    for (int r = 0; r < 9; r++) {
+        for (int c = 0; c < 9; c++) {
+            int k = r * 9 + c;
+            uint16_t used = rowUsed[r] | colUsed[c] | boxUsed[SudokuGrid::tables.cellBox[k]];
+            pencil[k] = value[k] ? 0 : (uint16_t)(SudokuGrid::ALL_DIGITS & ~used);
+        }
+    }
+}
+
+#ifdef PENCIL_X86
+/*  Columns 0-7 of a row as eight 16-bit lanes; column 8 is done by
+    the caller. value + r*9 has at least 8 bytes left for every row. */
+static inline __m128i rowCandidates(int r, __m128i cols, __m128i boxes,
+                                    const uint16_t *rowUsed, const uint8_t *value) {
+    __m128i used = _mm_or_si128(_mm_or_si128(cols, boxes),
+                                _mm_set1_epi16((short)rowUsed[r]));
+    __m128i cand = _mm_andnot_si128(used, _mm_set1_epi16(SudokuGrid::ALL_DIGITS));
+    __m128i vals = _mm_unpacklo_epi8(
+        _mm_loadl_epi64((const __m128i *)(value + r * 9)), _mm_setzero_si128());
+    return _mm_and_si128(cand, _mm_cmpeq_epi16(vals, _mm_setzero_si128()));
+}
+
+/*  Box masks for columns 0-7 of every row in band b */
+static inline __m128i bandBoxes(int b, const uint16_t *boxUsed) {
+    short b0 = (short)boxUsed[3 * b], b1 = (short)boxUsed[3 * b + 1],
+          b2 = (short)boxUsed[3 * b + 2];
+    return _mm_setr_epi16(b0, b0, b0, b1, b1, b1, b2, b2);
+}
+
+static inline uint16_t lastColumn(int r, const uint16_t *rowUsed,
+                                  const uint16_t *colUsed, const uint16_t *boxUsed,
+                                  const uint8_t *value) {
+    uint16_t used = rowUsed[r] | colUsed[8] | boxUsed[(r / 3) * 3 + 2];
+    return value[r * 9 + 8] ? 0 : (uint16_t)(SudokuGrid::ALL_DIGITS & ~used);
+}
+
+static void pencilSSE2(const uint16_t *rowUsed, const uint16_t *colUsed,
+                       const uint16_t *boxUsed, const uint8_t *value,
+                       uint16_t *pencil) {
+    __m128i cols = _mm_loadu_si128((const __m128i *)colUsed);
+    for (int b = 0; b < 3; b++) {
+        __m128i boxes = bandBoxes(b, boxUsed);
+        for (int r = 3 * b; r < 3 * b + 3; r++) {
+            _mm_storeu_si128((__m128i *)(pencil + r * 9),
+                             rowCandidates(r, cols, boxes, rowUsed, value));
+            pencil[r * 9 + 8] = lastColumn(r, rowUsed, colUsed, boxUsed, value);
+        }
+    }
+}
+
+/*  Two rows per 256-bit register, one in each 128-bit half; the
+    ninth column of rows 0-7 goes through one more 128-bit pass */
+__attribute__((target("avx2")))
+static void pencilAVX2(const uint16_t *rowUsed, const uint16_t *colUsed,
+                       const uint16_t *boxUsed, const uint8_t *value,
+                       uint16_t *pencil) {
+    __m128i cols128 = _mm_loadu_si128((const __m128i *)colUsed);
+    __m256i cols = _mm256_broadcastsi128_si256(cols128);
+    __m256i all = _mm256_set1_epi16(SudokuGrid::ALL_DIGITS);
+    __m128i band[3] = {bandBoxes(0, boxUsed), bandBoxes(1, boxUsed),
+                       bandBoxes(2, boxUsed)};
+    __m128i rowsUsed = _mm_loadu_si128((const __m128i *)rowUsed);
+    for (int r = 0; r < 8; r += 2) {
+        __m256i boxes = _mm256_setr_m128i(band[r / 3], band[(r + 1) / 3]);
+        __m256i rows = _mm256_setr_m128i(_mm_set1_epi16((short)rowUsed[r]),
+                                         _mm_set1_epi16((short)rowUsed[r + 1]));
+        __m256i vals = _mm256_setr_m128i(
+            _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(value + r * 9))),
+            _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(value + r * 9 + 9))));
+        __m256i used = _mm256_or_si256(_mm256_or_si256(cols, boxes), rows);
+        __m256i cand = _mm256_and_si256(_mm256_andnot_si256(used, all),
+            _mm256_cmpeq_epi16(vals, _mm256_setzero_si256()));
+        _mm_storeu_si128((__m128i *)(pencil + r * 9), _mm256_castsi256_si128(cand));
+        _mm_storeu_si128((__m128i *)(pencil + r * 9 + 9), _mm256_extracti128_si256(cand, 1));
+    }
+    // column 8 of rows 0-7: row masks vary by lane, column mask is fixed
+    short b2 = (short)boxUsed[2], b5 = (short)boxUsed[5], b8 = (short)boxUsed[8];
+    __m128i used8 = _mm_or_si128(_mm_or_si128(rowsUsed, _mm_set1_epi16((short)colUsed[8])),
+                                 _mm_setr_epi16(b2, b2, b2, b5, b5, b5, b8, b8));
+    __m128i vals8 = _mm_setr_epi16(value[8], value[17], value[26], value[35],
+                                   value[44], value[53], value[62], value[71]);
+    __m128i cand8 = _mm_and_si128(_mm_andnot_si128(used8, _mm256_castsi256_si128(all)),
+                                  _mm_cmpeq_epi16(vals8, _mm_setzero_si128()));
+    alignas(16) uint16_t last[8];
+    _mm_store_si128((__m128i *)last, cand8);
+    for (int r = 0; r < 8; r++)
+        pencil[r * 9 + 8] = last[r];
+    _mm_storeu_si128((__m128i *)(pencil + 72),
+                     rowCandidates(8, cols128, band[2], rowUsed, value));
+    pencil[80] = lastColumn(8, rowUsed, colUsed, boxUsed, value);
+}
+#endif
+
+/*  Picks the widest kernel this CPU runs, unless SUDOKU_PENCILS names
+    one (scalar, sse2 or avx2) */
+static PencilKernel selectKernel() {
+    const char *want = getenv("SUDOKU_PENCILS");
+    if (want != nullptr && !strcmp(want, "scalar"))
+        return pencilScalar;
+#ifdef PENCIL_X86
+    if (want != nullptr && !strcmp(want, "sse2"))
+        return pencilSSE2;
+    if (__builtin_cpu_supports("avx2"))
+        return pencilAVX2;
+    return pencilSSE2;
+#else
+    return pencilScalar;
+#endif
+}
+
+void pencilAllCells(SudokuGrid &grid) {
+    static const PencilKernel kernel = selectKernel();
+    kernel(grid.used.data(), grid.used.data() + 9, grid.used.data() + 18,
+           grid.value.data(), grid.pencil.data());
+}
@@ -0,0 +1,17 @@
+#ifndef PERCENTILE_H
+#define PERCENTILE_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/*  Nearest-rank p'th percentile of sorted samples: the smallest sample
+    with at least p percent of them at or below it (0 for none), so
+    sudokubench and sudokuclient agree on a median or p99 */
+inline double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)std::ceil(p / 100 * sorted.size());
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+#endif // PERCENTILE_H
@@ -0,0 +1,139 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "PuzzleFile.h"
+
+using namespace std;
+
+static const char MAGIC[4] = {'S', 'D', 'K', 'P'};
+
+static uint64_t readLE64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = v << 8 | p[i];
+    return v;
+}
+
+static void writeLE64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++, v >>= 8) p[i] = (uint8_t)v;
+}
+
+/*  Checks a header; returns an error message or nullptr */
+static const char *checkHeader(const uint8_t *h) {
+    if (memcmp(h, MAGIC, 4) != 0)
+        return "not a packed puzzle file";
+    if (h[4] != PuzzleFileFormat::VERSION)
+        return "unknown packed puzzle file version";
+    if (h[5] < 2 || h[5] > 5 || h[6] != PuzzleFileFormat::bitsPerCell(h[5]))
+        return "bad packed puzzle file header";
+    return nullptr;
+}
+
+MappedPuzzleFile::~MappedPuzzleFile() {
+    if (map_ != nullptr)
+        munmap(map_, size_);
+}
+
+bool MappedPuzzleFile::open(const char *path, string &error) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        error = strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        error = strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if ((size_t)st.st_size < (size_t)PuzzleFileFormat::HEADER_BYTES) {
+        error = "not a packed puzzle file";
+        ::close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file
+    if (map == MAP_FAILED) {
+        error = strerror(errno);
+        return false;
+    }
+    const uint8_t *h = (const uint8_t *)map;
+    const char *bad = checkHeader(h);
+    size_t bytes = PuzzleFileFormat::recordBytes(h[5]);
+    uint64_t count = bad ? 0 : readLE64(h + 8);
+    if (!bad && (st.st_size - PuzzleFileFormat::HEADER_BYTES) / bytes < count)
+        bad = "packed puzzle file is truncated";
+    if (bad) {
+        error = bad;
+        munmap(map, st.st_size);
+        return false;
+    }
+    // the records are read front to back, once
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    map_ = map;
+    size_ = st.st_size;
+    boxSize_ = h[5];
+    count_ = count;
+    recordBytes_ = bytes;
+    return true;
+}
+
+int MappedPuzzleFile::boxSizeOf(const char *path) {
+    uint8_t h[PuzzleFileFormat::HEADER_BYTES];
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+        return 0;
+    size_t got = fread(h, 1, sizeof h, f);
+    fclose(f);
+    return got == sizeof h && checkHeader(h) == nullptr ? h[5] : 0;
+}
+
+PuzzleFileWriter::~PuzzleFileWriter() {
+    if (file_ != nullptr)
+        fclose(file_);
+}
+
+bool PuzzleFileWriter::open(const char *path, int boxSize, string &error) {
+    file_ = fopen(path, "wb");
+    if (file_ == nullptr) {
+        error = strerror(errno);
+        return false;
+    }
+    boxSize_ = boxSize;
+    count_ = 0;
+    // the count is filled in by close()
+    uint8_t h[PuzzleFileFormat::HEADER_BYTES] = {};
+    memcpy(h, MAGIC, 4);
+    h[4] = PuzzleFileFormat::VERSION;
+    h[5] = (uint8_t)boxSize;
+    h[6] = (uint8_t)PuzzleFileFormat::bitsPerCell(boxSize);
+    if (fwrite(h, 1, sizeof h, file_) != sizeof h) {
+        error = strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool PuzzleFileWriter::write(const uint8_t *record) {
+    size_t bytes = PuzzleFileFormat::recordBytes(boxSize_);
+    if (fwrite(record, 1, bytes, file_) != bytes)
+        return false;
+    count_++;
+    return true;
+}
+
+bool PuzzleFileWriter::close(string &error) {
+    uint8_t count[8];
+    writeLE64(count, count_);
+    bool ok = !ferror(file_) && fseek(file_, 8, SEEK_SET) == 0 &&
+              fwrite(count, 1, sizeof count, file_) == sizeof count;
+    if (!ok) error = strerror(errno);
+    if (fclose(file_) != 0 && ok) {
+        error = strerror(errno);
+        ok = false;
+    }
+    file_ = nullptr;
+    return ok;
+}
@@ -0,0 +1,136 @@
+#ifndef PUZZLEFILE_H
+#define PUZZLEFILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "SudokuGrid.h"
+
+/*  Packed puzzle files: a 16 byte header, then one fixed size record
+    per grid (puzzle or solution alike). A record holds the cells in
+    row-major order, 4 bits each (low nibble first) for boards of up to
+    15 digits, so a 9x9 grid takes 41 bytes; 16x16 and 25x25 boards
+    take a byte per cell. A cell holds its digit, 0 when empty.
+
+    Header, all integers little-endian:
+        0  "SDKP"     magic
+        4  uint8      format version (1)
+        5  uint8      B, the box size (2..5)
+        6  uint8      bits per cell (4 or 8)
+        7  uint8      reserved, 0
+        8  uint64     number of records */
+struct PuzzleFileFormat {
+    static constexpr int HEADER_BYTES = 16;
+    static constexpr uint8_t VERSION = 1;
+
+    static int bitsPerCell(int boxSize) {
+        return boxSize * boxSize < 16 ? 4 : 8;
+    }
+    static size_t recordBytes(int boxSize) {
+        int cells = boxSize * boxSize * boxSize * boxSize;
+        return ((size_t)cells * bitsPerCell(boxSize) + 7) / 8;
+    }
+};
+
+/*  Writes grid as one record */
+template <int B>
+void packGrid(const BasicSudokuGrid<B> &grid, uint8_t *record) {
+    typedef BasicSudokuGrid<B> Grid;
+    if (PuzzleFileFormat::bitsPerCell(B) == 8) {
+        for (int k = 0; k < Grid::CELLS; k++)
+            record[k] = (uint8_t)grid.number(k);
+        return;
+    }
+    for (int k = 0; k + 1 < Grid::CELLS; k += 2)
+        record[k / 2] = (uint8_t)(grid.number(k) | grid.number(k + 1) << 4);
+    if (Grid::CELLS % 2)
+        record[Grid::CELLS / 2] = (uint8_t)grid.number(Grid::CELLS - 1);
+}
+
+/*  True unless some cell of a record holds a value past N: a quick
+    check for a damaged record, without unpacking it */
+template <int B>
+bool goodRecord(const uint8_t *record) {
+    const int N = B * B;
+    bool good = true;
+    if (PuzzleFileFormat::bitsPerCell(B) == 8) {
+        for (int k = 0; k < N * N; k++)
+            good &= record[k] <= N;
+    } else {
+        for (size_t i = 0; i < PuzzleFileFormat::recordBytes(B); i++)
+            good &= (record[i] & 15) <= N && record[i] >> 4 <= N;
+    }
+    return good;
+}
+
+/*  Fills an empty grid in from a record; the digits read count as
+    givens, as they do for a text puzzle. False if a cell holds a value
+    past N: the record is damaged, like a bogus puzzle line, and the
+    grid is left part filled */
+template <int B>
+bool unpackGrid(const uint8_t *record, BasicSudokuGrid<B> &grid) {
+    typedef BasicSudokuGrid<B> Grid;
+    bool wide = PuzzleFileFormat::bitsPerCell(B) == 8;
+    for (int k = 0; k < Grid::CELLS; k++) {
+        int n = wide ? record[k] : (record[k / 2] >> (k % 2 * 4)) & 15;
+        if (n == 0) continue;
+        if (n > Grid::N) return false;
+        int row = Grid::tables.cellRow[k], col = Grid::tables.cellCol[k];
+        grid.setNumber(row, col, n);
+        grid.setSolved(row, col);
+    }
+    return true;
+}
+
+/*  A packed puzzle file mapped read-only into memory: records are read
+    in place, with no copy and no parsing */
+class MappedPuzzleFile {
+public:
+    MappedPuzzleFile() : map_(nullptr), size_(0), boxSize_(0), count_(0),
+                         recordBytes_(0) {}
+    ~MappedPuzzleFile();
+    MappedPuzzleFile(const MappedPuzzleFile &) = delete;
+    MappedPuzzleFile &operator=(const MappedPuzzleFile &) = delete;
+
+    /*  Maps path; on failure returns false with the reason in error */
+    bool open(const char *path, std::string &error);
+
+    /*  Box size of the packed file at path, 0 if it is not one */
+    static int boxSizeOf(const char *path);
+
+    int boxSize() const { return boxSize_; }
+    uint64_t count() const { return count_; }
+    const uint8_t *record(uint64_t i) const {
+        return (const uint8_t *)map_ + PuzzleFileFormat::HEADER_BYTES +
+            i * recordBytes_;
+    }
+
+private:
+    void *map_;
+    size_t size_;
+    int boxSize_;
+    uint64_t count_;
+    size_t recordBytes_;
+};
+
+/*  Appends records to a new packed file, filling in the record count
+    in the header on close() */
+class PuzzleFileWriter {
+public:
+    PuzzleFileWriter() : file_(nullptr), boxSize_(0), count_(0) {}
+    ~PuzzleFileWriter();
+    PuzzleFileWriter(const PuzzleFileWriter &) = delete;
+    PuzzleFileWriter &operator=(const PuzzleFileWriter &) = delete;
+
+    bool open(const char *path, int boxSize, std::string &error);
+    bool write(const uint8_t *record);
+    bool close(std::string &error);
+    uint64_t count() const { return count_; }
+
+private:
+    FILE *file_;
+    int boxSize_;
+    uint64_t count_;
+};
+
+#endif // PUZZLEFILE_H
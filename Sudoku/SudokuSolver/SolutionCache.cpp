@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "SolutionCache.h"
+#include "SudokuSolver.h"
+
+using namespace std;
+
+template <int B>
+void Symmetry<B>::apply(const Grid &grid, Cells &out) const {
+    for (int row = 0; row < Grid::N; row++)
+        for (int col = 0; col < Grid::N; col++)
+            out[Grid::cell(row, col)] = digits[grid.number(source(row, col))];
+}
+
+template <int B>
+void Symmetry<B>::unapply(const Cells &cells, Grid &grid) const {
+    uint8_t from[Grid::N + 1];
+    for (int d = 0; d <= Grid::N; d++)
+        from[digits[d]] = (uint8_t)d;
+    for (int row = 0; row < Grid::N; row++) {
+        for (int col = 0; col < Grid::N; col++) {
+            int k = source(row, col);
+            grid.setNumber(k / Grid::N, k % Grid::N, from[cells[Grid::cell(row, col)]]);
+        }
+    }
+}
+
+namespace {
+
+/*  What canonicalize() orders the lines of one direction by: a line's
+    clue count, then the clue counts of the crossing lines through its
+    clues, largest first. No symmetry changes a line's key; it just
+    moves the line (and a transposition swaps rows for columns) */
+template <int B>
+using LineKey = array<uint8_t, B * B + 1>;
+
+/*  Every order of the N lines of one direction (as output line <- input
+    line) that keeps bands together and puts bands and the lines within
+    them in descending key order; lines or bands with equal keys can go
+    either way, and each way is listed. False if that is more than
+    limit orders */
+template <int B>
+bool lineOrders(const LineKey<B> *keys, unsigned long limit,
+                vector<array<uint8_t, B * B>> &orders) {
+    typedef array<LineKey<B>, B> BandKey;
+    BandKey bandKeys[B];
+    int bands[B], lines[B][B];
+    for (int b = 0; b < B; b++) {
+        for (int i = 0; i < B; i++) {
+            bandKeys[b][i] = keys[b * B + i];
+            lines[b][i] = i;
+        }
+        sort(bandKeys[b].begin(), bandKeys[b].end(), greater<LineKey<B>>());
+        sort(lines[b], lines[b] + B, [&](int x, int y) {
+            const LineKey<B> &kx = keys[b * B + x], &ky = keys[b * B + y];
+            return kx != ky ? kx > ky : x < y;
+        });
+        bands[b] = b;
+    }
+    sort(bands, bands + B, [&](int x, int y) {
+        return bandKeys[x] != bandKeys[y] ? bandKeys[x] > bandKeys[y] : x < y;
+    });
+
+    // the runs of equal keys, each stepped through its permutations
+    // like the wheels of an odometer
+    vector<pair<int *, int *>> ties;
+    unsigned long count = 1;
+    for (int i = 0, j; i < B; i = j) {
+        for (j = i + 1; j < B && bandKeys[bands[j]] == bandKeys[bands[i]]; j++) {}
+        if (j - i > 1) ties.emplace_back(bands + i, bands + j);
+        for (int f = 2; f <= j - i; f++) count *= f;
+    }
+    for (int b = 0; b < B; b++) {
+        for (int i = 0, j; i < B; i = j) {
+            for (j = i + 1; j < B && keys[b * B + lines[b][j]] == keys[b * B + lines[b][i]]; j++) {}
+            if (j - i > 1) ties.emplace_back(lines[b] + i, lines[b] + j);
+            for (int f = 2; f <= j - i; f++) count *= f;
+        }
+        if (count > limit) return false;
+    }
+
+    for (;;) {
+        array<uint8_t, B * B> order;
+        for (int ob = 0; ob < B; ob++)
+            for (int i = 0; i < B; i++)
+                order[ob * B + i] = (uint8_t)(bands[ob] * B + lines[bands[ob]][i]);
+        orders.push_back(order);
+        size_t t = 0;
+        while (t < ties.size() && !next_permutation(ties[t].first, ties[t].second))
+            t++;
+        if (t == ties.size())
+            return true;
+    }
+}
+
+} // namespace
+
+template <int B>
+bool canonicalize(const BasicSudokuGrid<B> &grid, Symmetry<B> &sym,
+                  typename Symmetry<B>::Cells &canon, unsigned long limit) {
+    typedef BasicSudokuGrid<B> Grid;
+    const int N = Grid::N;
+    int rowClues[N] = {}, colClues[N] = {};
+    for (int k = 0; k < Grid::CELLS; k++) {
+        if (grid.number(k) != 0) {
+            rowClues[k / N]++;
+            colClues[k % N]++;
+        }
+    }
+    LineKey<B> rowKeys[N], colKeys[N];
+    for (int i = 0; i < N; i++) {
+        rowKeys[i].fill(0);
+        colKeys[i].fill(0);
+        rowKeys[i][0] = (uint8_t)rowClues[i];
+        colKeys[i][0] = (uint8_t)colClues[i];
+        int r = 1, c = 1;
+        for (int j = 0; j < N; j++) {
+            if (grid.number(i, j) != 0) rowKeys[i][r++] = (uint8_t)colClues[j];
+            if (grid.number(j, i) != 0) colKeys[i][c++] = (uint8_t)rowClues[j];
+        }
+        sort(rowKeys[i].begin() + 1, rowKeys[i].end(), greater<uint8_t>());
+        sort(colKeys[i].begin() + 1, colKeys[i].end(), greater<uint8_t>());
+    }
+
+    // the image's rows must not come before its columns in key order
+    LineKey<B> rowSet[N], colSet[N];
+    copy(rowKeys, rowKeys + N, rowSet);
+    copy(colKeys, colKeys + N, colSet);
+    sort(rowSet, rowSet + N, greater<LineKey<B>>());
+    sort(colSet, colSet + N, greater<LineKey<B>>());
+    bool rowsFirst = lexicographical_compare(colSet, colSet + N, rowSet, rowSet + N);
+    bool colsFirst = lexicographical_compare(rowSet, rowSet + N, colSet, colSet + N);
+
+    bool found = false;
+    unsigned long tried = 0;
+    vector<array<uint8_t, N>> rowOrders, colOrders;
+    for (int transpose = 0; transpose < 2; transpose++) {
+        if ((transpose && rowsFirst) || (!transpose && colsFirst)) continue;
+        rowOrders.clear();
+        colOrders.clear();
+        if (!lineOrders<B>(transpose ? colKeys : rowKeys, limit, rowOrders) ||
+            !lineOrders<B>(transpose ? rowKeys : colKeys, limit, colOrders))
+            return false;
+        tried += rowOrders.size() * colOrders.size();
+        if (tried > limit)
+            return false;
+
+        Symmetry<B> cand;
+        cand.transpose = transpose;
+        typename Symmetry<B>::Cells image;
+        for (auto &rows : rowOrders) {
+            cand.rows = rows;
+            for (auto &cols : colOrders) {
+                cand.cols = cols;
+                // build the image cell by cell, giving up as soon as it
+                // is known to come after the best so far
+                uint8_t label[N + 1] = {};
+                int next = 1;
+                bool less = !found, worse = false;
+                for (int k = 0; k < Grid::CELLS && !worse; k++) {
+                    int d = grid.number(cand.source(k / N, k % N));
+                    if (d != 0 && label[d] == 0) label[d] = (uint8_t)next++;
+                    uint8_t v = label[d];
+                    if (!less) {
+                        if (v > canon[k]) worse = true;
+                        else if (v < canon[k]) less = true;
+                    }
+                    image[k] = v;
+                }
+                if (worse || !less) continue;
+                canon = image;
+                sym = cand;
+                found = true;
+            }
+        }
+    }
+
+    // number the digits in order of first appearance, then any the
+    // puzzle does not use
+    sym.digits.fill(0);
+    int next = 1;
+    for (int k = 0; k < Grid::CELLS; k++) {
+        int d = grid.number(sym.source(k / N, k % N));
+        if (d != 0 && sym.digits[d] == 0) sym.digits[d] = (uint8_t)next++;
+    }
+    for (int d = 1; d <= N; d++)
+        if (sym.digits[d] == 0) sym.digits[d] = (uint8_t)next++;
+    return true;
+}
+
+template <int B>
+size_t SolutionCache<B>::Hash::operator()(const Cells &cells) const {
+    uint64_t h = 14695981039346656037ull;  // FNV-1a
+    for (uint8_t v : cells)
+        h = (h ^ v) * 1099511628211ull;
+    return (size_t)h;
+}
+
+template <int B>
+bool SolutionCache<B>::lookup(const Cells &canon, Cells &solution) {
+    lock_guard<mutex> guard(lock_);
+    auto iter = index_.find(canon);
+    if (iter == index_.end())
+        return false;
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    solution = iter->second->solution;
+    return true;
+}
+
+template <int B>
+void SolutionCache<B>::insert(const Cells &canon, const Cells &solution) {
+    lock_guard<mutex> guard(lock_);
+    if (capacity_ == 0)
+        return;
+    auto iter = index_.find(canon);
+    if (iter != index_.end()) {
+        // another thread got there first
+        lru_.splice(lru_.begin(), lru_, iter->second);
+        return;
+    }
+    if (index_.size() == capacity_) {
+        // reuse the least recently used entry
+        index_.erase(lru_.back().canon);
+        lru_.splice(lru_.begin(), lru_, prev(lru_.end()));
+        lru_.front() = Entry{canon, solution};
+    } else {
+        lru_.push_front(Entry{canon, solution});
+    }
+    index_.emplace(canon, lru_.begin());
+}
+
+template <int B>
+size_t SolutionCache<B>::size() {
+    lock_guard<mutex> guard(lock_);
+    return index_.size();
+}
+
+/*  Reads CELLS digit characters into cells; false unless they all are */
+template <int B>
+static bool parseCells(const string &line, size_t start,
+                       typename Symmetry<B>::Cells &cells) {
+    typedef BasicSudokuGrid<B> Grid;
+    for (int k = 0; k < Grid::CELLS; k++) {
+        char c = line[start + k];
+        if (!Grid::isDigitChar(c)) return false;
+        cells[k] = (uint8_t)Grid::charDigit(c);
+    }
+    return true;
+}
+
+template <int B>
+bool SolutionCache<B>::load(const char *path, string &error) {
+    typedef BasicSudokuGrid<B> Grid;
+    ifstream in(path);
+    if (!in) {
+        if (errno == ENOENT) return true;
+        error = strerror(errno);
+        return false;
+    }
+    string line;
+    unsigned long lineno = 0;
+    while (getline(in, line)) {
+        lineno++;
+        Cells canon, solution;
+        int where;
+        // an edited or half written file must not turn into wrong answers
+        if (line.size() != 2 * (size_t)Grid::CELLS + 1 || line[Grid::CELLS] != ' ' ||
+            !parseCells<B>(line, 0, canon) || !parseCells<B>(line, Grid::CELLS + 1, solution) ||
+            checkSolution<B>(line.c_str(), line.c_str() + Grid::CELLS + 1, where) !=
+                SolutionFault::None) {
+            error = "line " + to_string(lineno) + ": bad cache entry";
+            return false;
+        }
+        insert(canon, solution);
+    }
+    return true;
+}
+
+template <int B>
+bool SolutionCache<B>::save(const char *path, string &error) {
+    typedef BasicSudokuGrid<B> Grid;
+    lock_guard<mutex> guard(lock_);
+    // write a new file and move it over the old one, so a failed save
+    // leaves the old cache as it was
+    string temp = string(path) + ".tmp";
+    FILE *f = fopen(temp.c_str(), "w");
+    if (f == nullptr) {
+        error = strerror(errno);
+        return false;
+    }
+    string line(2 * Grid::CELLS + 2, ' ');
+    line.back() = '\n';
+    for (auto iter = lru_.rbegin(); iter != lru_.rend(); ++iter) {
+        for (int k = 0; k < Grid::CELLS; k++) {
+            line[k] = Grid::digitChar(iter->canon[k]);
+            line[Grid::CELLS + 1 + k] = Grid::digitChar(iter->solution[k]);
+        }
+        fwrite(line.data(), 1, line.size(), f);
+    }
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (ok && rename(temp.c_str(), path) != 0) ok = false;
+    if (!ok) {
+        error = strerror(errno);
+        remove(temp.c_str());
+    }
+    return ok;
+}
+
+#define INSTANTIATE_CACHE(B) \
+    template struct Symmetry<B>; \
+    template bool canonicalize(const BasicSudokuGrid<B> &, Symmetry<B> &, \
+                               Symmetry<B>::Cells &, unsigned long); \
+    template class SolutionCache<B>;
+
+INSTANTIATE_CACHE(2)
+INSTANTIATE_CACHE(3)
+INSTANTIATE_CACHE(4)
+INSTANTIATE_CACHE(5)
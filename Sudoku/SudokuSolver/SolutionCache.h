@@ -0,0 +1,90 @@
+#ifndef SOLUTIONCACHE_H
+#define SOLUTIONCACHE_H
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "SudokuGrid.h"
+
+/*  One symmetry of the board: a transposition, then an order of the
+    rows that keeps each band together (bands reordered, rows reordered
+    within their band), the same for columns and stacks, and a
+    relabelling of the digits. Every one of them takes a puzzle to an
+    equivalent puzzle and its solution to the new puzzle's solution. */
+template <int B>
+struct Symmetry {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef std::array<uint8_t, Grid::CELLS> Cells;  // values, row-major
+
+    bool transpose;
+    std::array<uint8_t, Grid::N> rows, cols;  // output line <- input line
+    std::array<uint8_t, Grid::N + 1> digits;  // input digit -> output, 0 -> 0
+
+    /*  The input cell that output cell (row, col) takes */
+    int source(int row, int col) const {
+        return transpose ? Grid::cell(cols[col], rows[row])
+                         : Grid::cell(rows[row], cols[col]);
+    }
+    /*  out = this symmetry applied to the values of grid */
+    void apply(const Grid &grid, Cells &out) const;
+    /*  Fills grid in with the values that this symmetry takes to cells */
+    void unapply(const Cells &cells, Grid &grid) const;
+};
+
+/*  Finds the canonical form of the puzzle in grid: the least image
+    under the symmetries (cells in row-major order, empty first, digits
+    numbered in order of first appearance), so two puzzles share a
+    canonical form exactly when one is a symmetry of the other. Leaves
+    the form in canon and a symmetry that gives it in sym.
+
+    Rather than try them all (about 10^12 for 9x9), only the symmetries
+    whose image has its bands, rows, stacks and columns in a fixed
+    order of their clue counts are tried, which leaves the same set of
+    images for every puzzle of a class. Puzzles with too many ties in
+    those counts would still need more than limit images to be tried;
+    those return false. */
+template <int B>
+bool canonicalize(const BasicSudokuGrid<B> &grid, Symmetry<B> &sym,
+                  typename Symmetry<B>::Cells &canon, unsigned long limit = 4096);
+
+/*  Bounded map from canonical puzzles to their canonical solutions,
+    dropping the least recently used past capacity. Safe to share
+    between threads. */
+template <int B>
+class SolutionCache {
+public:
+    typedef typename Symmetry<B>::Cells Cells;
+
+    explicit SolutionCache(size_t capacity) : capacity_(capacity) {}
+
+    /*  Copies the solution of canon to solution if it is cached */
+    bool lookup(const Cells &canon, Cells &solution);
+    void insert(const Cells &canon, const Cells &solution);
+
+    /*  Reads "<canonical puzzle> <canonical solution>" lines, oldest
+        first, as save() writes them; a missing file is an empty cache.
+        On failure returns false with the reason in error */
+    bool load(const char *path, std::string &error);
+    bool save(const char *path, std::string &error);
+
+    size_t size();
+
+private:
+    struct Entry {
+        Cells canon, solution;
+    };
+    struct Hash {
+        size_t operator()(const Cells &cells) const;
+    };
+    typedef std::list<Entry> List;
+
+    size_t capacity_;
+    std::mutex lock_;
+    List lru_;  // most recently used first
+    std::unordered_map<Cells, typename List::iterator, Hash> index_;
+};
+
+#endif // SOLUTIONCACHE_H
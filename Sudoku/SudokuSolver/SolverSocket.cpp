@@ -0,0 +1,123 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "SolverSocket.h"
+
+using namespace std;
+
+constexpr size_t SolverProtocol::MAX_FRAME;
+constexpr char SolverProtocol::SOLVED;
+constexpr char SolverProtocol::UNSOLVABLE;
+constexpr char SolverProtocol::ERROR;
+
+void appendFrame(string &out, const string &payload) {
+    uint32_t n = (uint32_t)payload.size();
+    char length[4] = {(char)(n >> 24), (char)(n >> 16), (char)(n >> 8), (char)n};
+    out.append(length, 4);
+    out += payload;
+}
+
+bool writeAll(int fd, const string &data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        // no SIGPIPE if the other end has gone: just fail
+        ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+size_t FrameReader::frameLength() const {
+    const unsigned char *p = (const unsigned char *)buffer_.data() + start_;
+    return (size_t)p[0] << 24 | (size_t)p[1] << 16 | (size_t)p[2] << 8 | p[3];
+}
+
+bool FrameReader::ready() const {
+    return end_ - start_ >= 4 && end_ - start_ >= 4 + frameLength();
+}
+
+FrameReader::Result FrameReader::next(string &frame) {
+    while (!ready()) {
+        if (end_ - start_ >= 4 && frameLength() > SolverProtocol::MAX_FRAME)
+            return Result::Bad;
+        // keep the partial frame at the front and fill in behind it
+        if (start_ > 0) {
+            memmove(buffer_.data(), buffer_.data() + start_, end_ - start_);
+            end_ -= start_;
+            start_ = 0;
+        }
+        ssize_t n = read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return Result::Bad;
+        if (n == 0) return end_ == start_ ? Result::End : Result::Bad;
+        end_ += n;
+    }
+    size_t length = frameLength();
+    frame.assign(buffer_.data() + start_ + 4, length);
+    start_ += 4 + length;
+    return Result::Frame;
+}
+
+/*  Fills addr in for path; false if path is too long for it */
+static bool unixAddress(const char *path, sockaddr_un &addr, string &error) {
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof addr.sun_path) {
+        error = "socket path too long";
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+    return true;
+}
+
+int listenUnix(const char *path, string &error) {
+    sockaddr_un addr;
+    if (!unixAddress(path, addr, error))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = strerror(errno);
+        return -1;
+    }
+    int bound = bind(fd, (sockaddr *)&addr, sizeof addr);
+    if (bound < 0 && errno == EADDRINUSE) {
+        // a socket left behind by a server that is gone can be reused;
+        // one that still answers cannot
+        struct stat st;
+        string ignored;
+        int live = connectUnix(path, ignored);
+        if (live >= 0) {
+            close(live);
+            error = "another server is listening there";
+            close(fd);
+            return -1;
+        }
+        if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+            unlink(path);
+        bound = bind(fd, (sockaddr *)&addr, sizeof addr);
+    }
+    if (bound < 0 || listen(fd, 64) < 0) {
+        error = strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectUnix(const char *path, string &error) {
+    sockaddr_un addr;
+    if (!unixAddress(path, addr, error))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof addr) < 0) {
+        error = strerror(errno);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
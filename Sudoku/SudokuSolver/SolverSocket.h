@@ -0,0 +1,66 @@
+#ifndef SOLVERSOCKET_H
+#define SOLVERSOCKET_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*  The protocol of solvesudoku --serve, over a Unix domain stream
+    socket. Every message is a frame: a 4 byte big-endian length, then
+    that many bytes.
+
+        request   one puzzle, written as for -B (N*N characters, no
+                  newline)
+        response  'S' and the solution in the same form, 'U' if the
+                  puzzle has no solution, or 'E' and a message if the
+                  request is not a puzzle
+
+    A client may send any number of requests before it reads a reply;
+    the replies on a connection come back in the order of its requests. */
+struct SolverProtocol {
+    static constexpr size_t MAX_FRAME = 4096;  // a 25x25 puzzle is 625
+    static constexpr char SOLVED = 'S';
+    static constexpr char UNSOLVABLE = 'U';
+    static constexpr char ERROR = 'E';
+};
+
+/*  Appends payload to out as one frame */
+void appendFrame(std::string &out, const std::string &payload);
+
+/*  Writes all of data to the socket fd; false if it failed or the
+    other end went away */
+bool writeAll(int fd, const std::string &data);
+
+/*  Splits what arrives on a socket into frames, reading as much as
+    there is at a time */
+class FrameReader {
+public:
+    enum class Result { Frame, End, Bad };
+
+    explicit FrameReader(int fd) : fd_(fd), buffer_(1 << 16), start_(0), end_(0) {}
+
+    /*  Moves the next frame into frame, reading (and blocking) only if
+        it has not all arrived yet. End at a clean end of the stream,
+        Bad on an error, a cut-off frame or one over MAX_FRAME */
+    Result next(std::string &frame);
+
+    /*  True if next() can return a frame without reading */
+    bool ready() const;
+
+private:
+    int fd_;
+    std::vector<char> buffer_;
+    size_t start_, end_;  // unread bytes
+
+    size_t frameLength() const;
+};
+
+/*  Binds and listens on a Unix socket at path, taking over a stale
+    socket file that nothing is listening on; -1 on failure, with the
+    reason in error */
+int listenUnix(const char *path, std::string &error);
+
+/*  Connects to the Unix socket at path; -1 on failure */
+int connectUnix(const char *path, std::string &error);
+
+#endif // SOLVERSOCKET_H
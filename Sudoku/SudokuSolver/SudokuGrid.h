@@ -3,84 +3,215 @@
 
 #include <array>
 #include <bitset>
+#include <cstdint>
 #include <string>
+#include <type_traits>
+#include "SudokuTables.h"
 
-class Cell {
+template <int B> class BasicSudokuGrid;
+void pencilAllCells(BasicSudokuGrid<3> &grid);
+
+/*  An N x N Sudoku (N = B * B) made of B x B boxes: B = 2 for 4x4,
+    3 for the classic 9x9, 4 for 16x16 and 5 for 25x25.
+
+    Grid state is kept structure-of-arrays in row-major cell order: one
+    byte per value, a candidate mask per cell, the fixed/solved flags as
+    bitsets and the used-digit masks per unit (numbered as in
+    SudokuTables). For 9x9 the whole grid is about 330 bytes, so copying
+    it to branch or to hand it to another thread is cheap.
+
+    Digits are written 1-9 then A, B, C... (so 16x16 uses 1-9 and A-G);
+    an empty cell is '.' or '0'. */
+template <int B>
+class BasicSudokuGrid {
 public:
-    int value;
-    std::bitset<9> pencils;
-    bool fixed;
-    bool solved;
-};
+    static constexpr int N = B * B;       // digits, cells per unit
+    static constexpr int CELLS = N * N;
+    // bit n-1 set <=> digit n
+    typedef typename std::conditional<(N <= 16), uint16_t, uint32_t>::type Mask;
+    static constexpr Mask ALL_DIGITS = (Mask)((1ull << N) - 1);
+    static constexpr SudokuTables<B> tables = SudokuTables<B>();
 
-class SudokuGrid {
 private:
-    std::array<std::array<Cell,9>,9> grid;
+    // bit n-1 set <=> digit n already used in that unit: the N rows,
+    // then the N columns, then the N boxes
+    std::array<Mask,3 * N> used;
+    std::array<Mask,CELLS> pencil;
+    std::array<uint8_t,CELLS> value;
+    std::bitset<CELLS> fixedCells;
+    std::bitset<CELLS> solvedCells;
+
+    friend void pencilAllCells(BasicSudokuGrid<3> &grid); // vectorized, PencilKernels.cpp
 public:
-    // implement the following
-
-    SudokuGrid(std::string s) {
-        int k = 0;
-        for(int i = 0; i < 9; i++) {
-            for(int j = 0; j < 9; j++) {
-                if(s[k] == '.') {
-                    grid[i][j].value = 0;
-                    grid[i][j].fixed = false;
-                    grid[i][j].solved = false;
-                } else {
-                    grid[i][j].value = (s[k] - '0');
-                    grid[i][j].fixed = false;
-                    grid[i][j].solved = true;
-                }
-                clearAllPencils(i, j);
-                k++;
+    /*  An empty board */
+    BasicSudokuGrid() {
+        used.fill(0);
+        pencil.fill(0);
+        value.fill(0);
+    }
+
+    /*  Reads CELLS characters of s in place; s need not be null
+        terminated */
+    explicit BasicSudokuGrid(const char *s) {
+        used.fill(0);
+        pencil.fill(0);
+        value.fill(0);
+        for(int k = 0; k < CELLS; k++) {
+            int n = charDigit(s[k]);
+            if(n != 0) {
+                setNumber(k / N, k % N, n);
+                solvedCells.set(k);
             }
         }
     } // constructor
 
+    BasicSudokuGrid(const std::string &s) : BasicSudokuGrid(s.data()) {}
+
+    /*  Digit written as c, 0 for an empty cell or anything else */
+    static int charDigit(char c) {
+        int n = ('1' <= c && c <= '9') ? c - '0' :
+                ('A' <= c && c <= 'Z') ? c - 'A' + 10 : 0;
+        return n <= N ? n : 0;
+    }
+    static char digitChar(int n) {
+        return n == 0 ? '.' : n <= 9 ? (char)('0' + n) : (char)('A' + n - 10);
+    }
+    static bool isDigitChar(char c) {
+        return c == '.' || c == '0' || charDigit(c) != 0;
+    }
+
+    static int cell(int row, int col) {
+        return row * N + col;
+    }
+    static int box(int row, int col) {
+        return tables.cellBox[cell(row, col)];
+    }
+    static Mask digitBit(int n) {
+        return (Mask)(1u << (n - 1));
+    }
+    static int lowestDigit(Mask mask) {
+        return __builtin_ctz(mask) + 1;
+    }
+    static int countDigits(Mask mask) {
+        return __builtin_popcount(mask);
+    }
+
     int number(int row, int col) const {
-        return grid[row][col].value;
+        return value[cell(row, col)];
     }
+    int number(int k) const { return value[k]; }
+    /*  Keeps the row/column/box masks in step with the cell value;
+        number 0 clears the cell */
     void setNumber(int row, int col, int number) {
-        grid[row][col].value = number;
+        int k = cell(row, col), b = 2 * N + box(row, col);
+        int old = value[k];
+        if (old != 0) {
+            Mask clear = (Mask)~digitBit(old);
+            used[row] &= clear;
+            used[N + col] &= clear;
+            used[b] &= clear;
+        }
+        value[k] = (uint8_t)number;
+        if (number != 0) {
+            Mask bit = digitBit(number);
+            used[row] |= bit;
+            used[N + col] |= bit;
+            used[b] |= bit;
+        }
     }
     bool isFixed(int row, int col) const {
-        return grid[row][col].fixed;
+        return fixedCells[cell(row, col)];
     }
     bool isSolved(int row, int col) const {
-        return grid[row][col].solved;
+        return solvedCells[cell(row, col)];
     }
     void setSolved(int row, int col) {
-        grid[row][col].solved = true;
+        solvedCells.set(cell(row, col));
+    }
+
+    /*  Digits that can still be placed at (row, col) without
+        clashing with its row, column or box */
+    Mask candidates(int row, int col) const {
+        return ALL_DIGITS & (Mask)~(used[row] | used[N + col] |
+                                    used[2 * N + box(row, col)]);
+    }
+    Mask candidates(int k) const {
+        const uint16_t *units = tables.cellUnits[k];
+        return ALL_DIGITS & (Mask)~(used[units[0]] | used[units[1]] |
+                                    used[units[2]]);
+    }
+    Mask rowMask(int row) const { return used[row]; }
+    Mask colMask(int col) const { return used[N + col]; }
+    Mask boxMask(int b) const { return used[2 * N + b]; }
+    Mask unitMask(int u) const { return used[u]; }
+    bool isUsed(int row, int col, int n) const {
+        return !(candidates(row, col) & digitBit(n));
     }
 
     bool isPencilSet(int row, int col, int n) const {
-        return grid[row][col].pencils[n-1];
+        return pencil[cell(row, col)] & digitBit(n);
     }
     bool anyPencilsSet(int row, int col) const {
-        for(int i = 0; i < 9; i++) {
-            if(grid[row][col].pencils[i]) {
-                return true;
-            }
-        }
-        return false;
+        return pencil[cell(row, col)] != 0;
+    }
+    Mask pencils(int row, int col) const {
+        return pencil[cell(row, col)];
+    }
+    Mask pencils(int k) const { return pencil[k]; }
+    void setPencils(int row, int col, Mask mask) {
+        pencil[cell(row, col)] = mask;
     }
+    void setPencils(int k, Mask mask) { pencil[k] = mask; }
     void setPencil(int row, int col, int n) {
-        grid[row][col].pencils[n-1] = true;
+        pencil[cell(row, col)] |= digitBit(n);
     }
     void setAllPencils(int row, int col) {
-        for(int i = 0; i < 9; i++) {
-            setPencil(row, col, i);
-        }
+        pencil[cell(row, col)] = ALL_DIGITS;
     }
     void clearPencil(int row, int col, int n) {
-        grid[row][col].pencils[n-1] = false;
+        pencil[cell(row, col)] &= (Mask)~digitBit(n);
     }
     void clearAllPencils(int row, int col) {
-        for(int i = 0; i < 9; i++) {
-            grid[row][col].pencils[i] = false;
-        }
+        pencil[cell(row, col)] = 0;
+    }
+
+    /*  Pencils in every empty cell's candidates and clears the pencils
+        of filled cells, all in one pass */
+    void pencilAll() {
+        for (int k = 0; k < CELLS; k++)
+            pencil[k] = value[k] ? 0 : candidates(k);
     }
 };
 
+template <int B> constexpr int BasicSudokuGrid<B>::N;
+template <int B> constexpr int BasicSudokuGrid<B>::CELLS;
+template <int B> constexpr typename BasicSudokuGrid<B>::Mask BasicSudokuGrid<B>::ALL_DIGITS;
+template <int B> constexpr SudokuTables<B> BasicSudokuGrid<B>::tables;
+
+/*  9x9 grids get the SSE2/AVX2 kernels */
+template <>
+inline void BasicSudokuGrid<3>::pencilAll() {
+    pencilAllCells(*this);
+}
+
+/*  Writes the grid to out as one compact line (CELLS characters and a
+    newline), in the format the constructor reads; returns the end */
+template <int B>
+char *formatGrid(const BasicSudokuGrid<B> &grid, char *out) {
+    for (int k = 0; k < BasicSudokuGrid<B>::CELLS; k++)
+        *out++ = BasicSudokuGrid<B>::digitChar(grid.number(k));
+    *out++ = '\n';
+    return out;
+}
+
+/*  Appends the grid to out as one compact line */
+template <int B>
+void formatGrid(const BasicSudokuGrid<B> &grid, std::string &out) {
+    size_t end = out.size();
+    out.resize(end + BasicSudokuGrid<B>::CELLS + 1);
+    formatGrid(grid, &out[end]);
+}
+
+typedef BasicSudokuGrid<3> SudokuGrid;
+
 #endif // SUDOKUGRID_H
@@ -0,0 +1,567 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "SudokuSolver.h"
+#include "IterativeSearch.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// the lookup tables are built by the compiler, not at startup
+static_assert(SudokuGrid::tables.peers[0][SudokuTables<3>::PEERS - 1] == 20 &&
+              SudokuGrid::tables.cellBox[80] == 8, "bad 9x9 tables");
+
+/*  Finds if there is a conflicting number in either the row column
+    or block if it finds one, return true else false */
+template <int B>
+bool conflictingNumber(BasicSudokuGrid<B> &grid, int row, int col, int num) {
+    return grid.isUsed(row, col, num);
+}
+
+/*  Pencils in all possibilities for each empty cell in the grid
+    straight from the row, column and block masks (all cells at once;
+    9x9 grids use the kernels in PencilKernels.cpp) */
+template <int B>
+void autoPencil(BasicSudokuGrid<B> &grid) {
+    grid.pencilAll();
+}
+
+/*  Places n at (row, col) and strikes it from the pencil marks of
+    every cell sharing its row, column or block. If dirty is given,
+    the units of every cell that lost a pencil mark (this one included)
+    are queued on it */
+template <int B>
+void place(BasicSudokuGrid<B> &grid, int row, int col, int n,
+           DirtyUnits<B> *dirty) {
+    typedef BasicSudokuGrid<B> Grid;
+    typename Grid::Mask bit = Grid::digitBit(n);
+    int cell = Grid::cell(row, col);
+    grid.clearAllPencils(row, col);
+    grid.setNumber(row, col, n);
+    grid.setSolved(row, col);
+    if (dirty != nullptr) dirty->touch(cell); // its other marks are gone
+    for (int k : Grid::tables.peers[cell]) {
+        typename Grid::Mask p = grid.pencils(k);
+        if (p & bit) {
+            grid.setPencils(k, p & (typename Grid::Mask)~bit);
+            if (dirty != nullptr) dirty->touch(k);
+        }
+    }
+}
+
+/*  Works through the queued units until none are left: a pencil mark
+    found in only one cell of a unit is placed there (a hidden single)
+    and, with nakedSingles, so is a cell's only pencil mark. Each
+    placement queues just the units whose pencils it changed. Pencils
+    must hold the candidates of every empty cell. Returns false if the
+    grid runs into a contradiction */
+template <int B>
+bool propagateUnits(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty,
+                    bool nakedSingles, SearchStats &stats) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename Grid::Mask Mask;
+    const int N = Grid::N;
+    const SudokuTables<B> &T = Grid::tables;
+    while (!dirty.empty()) {
+        int u = dirty.pop();
+        const uint16_t *cells = T.unitCells[u];
+        Mask once = 0, twice = 0;
+        for (int i = 0; i < N; i++) {
+            int k = cells[i];
+            if (grid.number(k) != 0) continue;
+            Mask p = grid.pencils(k);
+            if (p == 0) return false; // nothing fits here
+            if (nakedSingles && (p & (p - 1)) == 0) {
+                place(grid, T.cellRow[k], T.cellCol[k], Grid::lowestDigit(p), &dirty);
+                stats.propagations++;
+                continue;
+            }
+            twice |= once & p;
+            once |= p;
+        }
+        // every digit must be placed or pencilled somewhere in the unit
+        if ((Mask)(once | grid.unitMask(u)) != Grid::ALL_DIGITS)
+            return false;
+        once &= (Mask)~twice;
+        for (int i = 0; once && i < N; i++) {
+            int k = cells[i];
+            // pencils only shrink, so a mark still present here is
+            // still the only one of its kind in the unit
+            Mask hidden = grid.pencils(k) & once;
+            if (!hidden) continue;
+            if (hidden & (hidden - 1)) return false; // two digits need this cell
+            place(grid, T.cellRow[k], T.cellCol[k], Grid::lowestDigit(hidden), &dirty);
+            stats.propagations++;
+            once &= (Mask)~hidden;
+        }
+    }
+    return true;
+}
+
+/*  Deductively solves a few places on the grid to lighten the load 
+    for solve, it does this by finding pencils that have no conflicting
+    pencil marks (hidden singles), rescanning only the rows, columns
+    and blocks a placement touched. The passes in passes then take
+    turns, cheapest first, placing the singles (naked ones too) each
+    elimination opens up, until the grid is full or a whole round finds
+    nothing more */
+template <int B>
+void deduce(BasicSudokuGrid<B> &grid, SearchStats &stats, unsigned passes) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef int (*Pass)(BasicSudokuGrid<B> &, DirtyUnits<B> &);
+    static const Pass chain[DEDUCE_PASSES] = {
+        lockedCandidates<B>, nakedSubsets<B>, hiddenSubsets<B>, xWing<B>
+    };
+    SearchStats singles;
+    DirtyUnits<B> dirty;
+    autoPencil(grid);
+    dirty.pushAll();
+    auto unfinished = [&grid]() {
+        int filled = 0;
+        for (int r = 0; r < Grid::N; r++)
+            filled += Grid::countDigits(grid.rowMask(r));
+        return filled < Grid::CELLS;
+    };
+    bool going = propagateUnits(grid, dirty, passes != 0, singles) && unfinished();
+    for (bool again = passes != 0; going && again; ) {
+        again = false;
+        for (int p = 0; going && p < DEDUCE_PASSES; p++) {
+            if (!(passes & (1u << p))) continue;
+            int struck = chain[p](grid, dirty);
+            if (struck == 0) continue;
+            stats.eliminated[p] += struck;
+            going = propagateUnits(grid, dirty, true, singles) && unfinished();
+            again = true;
+        }
+    }
+    SUDOKU_STAT(stats.deduced += singles.propagations);
+}
+
+template <int B>
+void deduce(BasicSudokuGrid<B> &grid) {
+    SearchStats ignored;
+    deduce(grid, ignored);
+}
+
+/*  Finds cells that do not have a proper value and gives the saves the row
+    col */
+template <int B>
+bool findUnassignedLocation(BasicSudokuGrid<B> &grid, int &row, int &col) {
+    const int N = B * B;
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            if (grid.number(i, j) == 0) {
+                row = i;
+                col = j;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/*  Finds the empty cell with the fewest legal candidates, breaking ties
+    by the cell whose row, column or block has the fewest empty cells
+    left; returns false if the grid is full */
+template <int B>
+bool findFewestCandidates(BasicSudokuGrid<B> &grid, int &row, int &col,
+                          SearchStats *stats) {
+    typedef BasicSudokuGrid<B> Grid;
+    const int N = Grid::N;
+    const SudokuTables<B> &T = Grid::tables;
+    (void)stats;  // only counted with SUDOKU_STATS
+    int best = N + 1, bestUnit = N + 1;
+    for (int k = 0; k < Grid::CELLS; k++) {
+        if (grid.number(k) != 0) continue;
+        SUDOKU_STAT(stats != nullptr && ++stats->checks);
+        int n = Grid::countDigits(grid.candidates(k));
+        if (n > best) continue;
+        const uint16_t *units = T.cellUnits[k];
+        int unit = N - max(Grid::countDigits(grid.unitMask(units[0])),
+                       max(Grid::countDigits(grid.unitMask(units[1])),
+                           Grid::countDigits(grid.unitMask(units[2]))));
+        if (n < best || unit < bestUnit) {
+            best = n;
+            bestUnit = unit;
+            row = T.cellRow[k];
+            col = T.cellCol[k];
+            if (n <= 1) return true; // can't do better than forced
+        }
+    }
+    return best <= N;
+}
+
+/*  Solutions found so far by a search and where the first one goes;
+    the search stops once limit of them have turned up */
+template <int B>
+struct SolutionCount {
+    int limit;
+    int found;
+    BasicSudokuGrid<B> *first;  // nullptr: leave it in the searched grid
+    SolutionCount(int limit, BasicSudokuGrid<B> *first)
+        : limit(limit), found(0), first(first) {}
+    /*  Called on a filled grid; true once the search can stop */
+    bool solved(const BasicSudokuGrid<B> &grid) {
+        if (found++ == 0 && first != nullptr && first != &grid)
+            *first = grid;
+        return found >= limit;
+    }
+};
+
+/*  Recursively solves the rest of the sudoku grid through a back tracking
+    algorithm, in place. Returns true once count has seen enough
+    solutions, leaving the grid as the last one; otherwise every guess
+    is undone. Gives up as soon as *stop is set */
+template <int B>
+static bool searchBacktrack(BasicSudokuGrid<B> &grid, Branching branching,
+                            SolutionCount<B> &count, SearchStats &stats,
+                            const atomic<bool> *stop) {
+    typedef BasicSudokuGrid<B> Grid;
+    int row, col;
+    stats.nodes++;
+    SUDOKU_STAT_FRAME(stats);
+    if (stop != nullptr && stop->load(memory_order_relaxed))
+        return false;
+    bool found = branching == Branching::FewestCandidates ?
+        findFewestCandidates(grid, row, col, &stats) :
+        findUnassignedLocation(grid, row, col);
+    if (!found)
+        return count.solved(grid); // puzzle filled, solution found!
+    SUDOKU_STAT(stats.checks++);
+    typename Grid::Mask cands = grid.candidates(row, col);
+    while (cands) {
+        int num = Grid::lowestDigit(cands);
+        cands &= cands - 1;
+        SUDOKU_STAT(stats.guesses++);
+        grid.setNumber(row, col, num); // try next number
+        if (searchBacktrack(grid, branching, count, stats, stop))
+            return true;               // solved!
+        SUDOKU_STAT(stats.backtracks++);
+        grid.setNumber(row, col, 0);   // not solved, clear number
+    }
+    return false; // not solved, back track
+}
+
+/*  Solves the rest of the sudoku grid through a back tracking
+    algorithm; gives up as soon as *stop is set */
+template <int B>
+bool solveSudoku(BasicSudokuGrid<B> &grid, Branching branching,
+                 SearchStats &stats, const atomic<bool> *stop) {
+    SolutionCount<B> count(1, nullptr);
+    return searchBacktrack(grid, branching, count, stats, stop);
+}
+
+/*  Places naked and hidden singles until none are left; pencils must
+    hold the candidates of every empty cell. Returns false if the grid
+    runs into a contradiction */
+template <int B>
+bool propagate(BasicSudokuGrid<B> &grid, SearchStats &stats) {
+    DirtyUnits<B> dirty;
+    dirty.pushAll();
+    return propagateUnits(grid, dirty, true, stats);
+}
+
+/*  One node of solvePropagating: dirty holds the units the guess that
+    led here touched. Each branch works on its own copy of the grid, so
+    backtracking is simply dropping the copy */
+template <int B>
+static bool searchPropagating(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty,
+                              SolutionCount<B> &count, SearchStats &stats,
+                              const atomic<bool> *stop) {
+    typedef BasicSudokuGrid<B> Grid;
+    const int N = Grid::N;
+    stats.nodes++;
+    SUDOKU_STAT_FRAME(stats);
+    if (stop != nullptr && stop->load(memory_order_relaxed))
+        return false;
+    if (!propagateUnits(grid, dirty, true, stats))
+        return false;
+    int cell = -1, best = N + 1;
+    for (int k = 0; k < Grid::CELLS; k++) {
+        if (grid.number(k) != 0) continue;
+        SUDOKU_STAT(stats.checks++);
+        int n = Grid::countDigits(grid.pencils(k));
+        if (n < best) {
+            best = n;
+            cell = k;
+        }
+    }
+    if (cell < 0)
+        return count.solved(grid); // puzzle filled, solution found!
+    int row = Grid::tables.cellRow[cell], col = Grid::tables.cellCol[cell];
+    typename Grid::Mask cands = grid.pencils(row, col);
+    while (cands) {
+        Grid branch = grid;
+        DirtyUnits<B> touched;
+        place(branch, row, col, Grid::lowestDigit(cands), &touched);
+        cands &= cands - 1;
+        SUDOKU_STAT(stats.guesses++);
+        if (searchPropagating(branch, touched, count, stats, stop))
+            return true;
+        SUDOKU_STAT(stats.backtracks++);
+    }
+    return false;
+}
+
+/*  Backtracking search that propagates singles after every tentative
+    assignment. Pencils must hold the candidates of every empty cell.
+    Gives up as soon as *stop is set */
+template <int B>
+bool solvePropagating(BasicSudokuGrid<B> &grid, SearchStats &stats,
+                      const atomic<bool> *stop) {
+    // the search is over as soon as the solution is copied back, so
+    // the copy may go straight into the root grid
+    SolutionCount<B> count(1, &grid);
+    DirtyUnits<B> dirty;
+    dirty.pushAll();
+    return searchPropagating(grid, dirty, count, stats, stop);
+}
+
+/*  False if two givens clash in some row, column or box */
+template <int B>
+bool consistentGivens(const BasicSudokuGrid<B> &grid) {
+    typedef BasicSudokuGrid<B> Grid;
+    const int N = Grid::N;
+    int filled = 0;
+    for (int k = 0; k < Grid::CELLS; k++)
+        filled += grid.number(k) != 0;
+    // the rows (and columns, and boxes) share out the filled cells, so
+    // a unit that repeats a digit leaves its kind's digits short
+    for (int kind = 0; kind < 3; kind++) {
+        int digits = 0;
+        for (int u = kind * N; u < (kind + 1) * N; u++)
+            digits += Grid::countDigits(grid.unitMask(u));
+        if (digits != filled)
+            return false;
+    }
+    return true;
+}
+
+/*  Character lookups for checkSolution, so a cell costs two loads and
+    no branches */
+template <int B>
+struct CharDigits {
+    typedef typename BasicSudokuGrid<B>::Mask Mask;
+    Mask bit[256];     // the digit's bit, 0 for anything else
+    bool cell[256];    // a digit or an empty cell
+    CharDigits() {
+        for (int c = 0; c < 256; c++) {
+            int n = BasicSudokuGrid<B>::charDigit((char)c);
+            bit[c] = n ? BasicSudokuGrid<B>::digitBit(n) : 0;
+            cell[c] = BasicSudokuGrid<B>::isDigitChar((char)c);
+        }
+    }
+};
+
+/*  Checks that solution (CELLS characters, as formatGrid writes them)
+    fills every cell, keeps the givens of puzzle and has every digit
+    once in each row, column and box. A unit of N cells holds every
+    digit exactly when the OR of their digit bits is ALL_DIGITS, so
+    each cell costs three ORs and no unit is scanned twice. Cell faults
+    are only looked for cell by cell once the fast pass has seen one.
+    On a fault, where is the cell (Bogus, Empty, Givens) or the row,
+    column or box number it was found in */
+template <int B>
+SolutionFault checkSolution(const char *puzzle, const char *solution, int &where) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename Grid::Mask Mask;
+    const int N = Grid::N;
+    static const CharDigits<B> chars;
+    const unsigned char *p = (const unsigned char *)puzzle;
+    const unsigned char *s = (const unsigned char *)solution;
+    Mask rows[N] = {}, cols[N] = {}, boxes[N] = {};
+    bool clean = true;
+    for (int r = 0, k = 0; r < N; r++) {
+        for (int c = 0; c < N; c++, k++) {
+            Mask bit = chars.bit[s[k]], given = chars.bit[p[k]];
+            clean &= (bit != 0) & ((given & ~bit) == 0) & chars.cell[p[k]];
+            rows[r] |= bit;
+            cols[c] |= bit;
+            boxes[Grid::tables.cellBox[k]] |= bit;
+        }
+    }
+    if (!clean) {
+        for (where = 0; where < Grid::CELLS; where++) {
+            if (!chars.cell[p[where]] || !chars.cell[s[where]])
+                return SolutionFault::Bogus;
+            if (chars.bit[s[where]] == 0)
+                return SolutionFault::Empty;
+            if (chars.bit[p[where]] & ~chars.bit[s[where]])
+                return SolutionFault::Givens;
+        }
+    }
+    const Mask *units[3] = {rows, cols, boxes};
+    const SolutionFault faults[3] = {SolutionFault::Row, SolutionFault::Column,
+                                     SolutionFault::Box};
+    for (int t = 0; t < 3; t++)
+        for (where = 0; where < N; where++)
+            if (units[t][where] != Grid::ALL_DIGITS)
+                return faults[t];
+    return SolutionFault::None;
+}
+
+/*  Counts the solutions of grid, stopping at limit, with the Backtrack,
+    Propagate or Iterative engine; the grid is left as the first
+    solution found (if any). The search state lives on the stack, so
+    counting allocates nothing */
+template <int B>
+int countSolutions(BasicSudokuGrid<B> &grid, Engine engine,
+                   Branching branching, int limit, SearchStats &stats) {
+    if (!consistentGivens(grid))
+        return 0;
+    if (engine == Engine::Iterative) {
+        IterativeSearch<B> search(grid, branching);
+        int found = 0;
+        while (found < limit &&
+               search.run(stats) == IterativeSearch<B>::Status::Solved)
+            if (found++ == 0)
+                grid = search.grid();
+        return found;
+    }
+    BasicSudokuGrid<B> first = grid;
+    SolutionCount<B> count(limit, &first);
+    if (engine == Engine::Propagate) {
+        autoPencil(grid);
+        DirtyUnits<B> dirty;
+        dirty.pushAll();
+        searchPropagating(grid, dirty, count, stats, nullptr);
+    } else {
+        searchBacktrack(grid, branching, count, stats, nullptr);
+    }
+    if (count.found > 0)
+        grid = first;
+    return count.found;
+}
+
+/*  solveParallel for the Iterative engine. Rather than a frontier fixed
+    up front, one search starts on the whole grid and runs in slices of
+    SLICE nodes. After each slice it gives its shallowest untried branch
+    (the biggest subtree it has left) to the pool as a search of its
+    own, so work keeps spreading for as long as any search has some */
+template <int B>
+static bool solveSplitting(BasicSudokuGrid<B> &grid, Branching branching,
+                           ThreadPool &pool, SearchStats &stats) {
+    typedef BasicSudokuGrid<B> Grid;
+    typedef typename IterativeSearch<B>::Status Status;
+    const unsigned long SLICE = 4096;
+    atomic<bool> stop(false);
+    mutex lock;
+    bool solved = false;
+    function<void(const Grid &)> spawn = [&](const Grid &part) {
+        pool.submit([&, part]() {
+            IterativeSearch<B> search(part, branching);
+            SearchStats local;
+            Status status;
+            while ((status = search.run(local, SLICE)) == Status::Paused &&
+                   !stop.load(memory_order_relaxed)) {
+                Grid branch = part;
+                if (search.split(branch))
+                    spawn(branch);
+            }
+            lock_guard<mutex> guard(lock);
+            stats.add(local);
+            if (status == Status::Solved && !solved) {
+                solved = true;
+                stop = true;
+                grid = search.grid();
+            }
+        });
+    };
+    spawn(grid);
+    pool.wait();
+    return solved;
+}
+
+/*  Splits the top of the search tree into independent subproblems, each
+    on its own copy of the grid, and solves them as tasks on the pool.
+    The first task to find a solution stops the rest. Handles the
+    Backtrack, Propagate and Iterative engines. */
+template <int B>
+bool solveParallel(BasicSudokuGrid<B> &grid, Engine engine,
+                   Branching branching, ThreadPool &pool, SearchStats &stats) {
+    typedef BasicSudokuGrid<B> Grid;
+    if (engine == Engine::Iterative)
+        return solveSplitting(grid, branching, pool, stats);
+    bool propagating = engine == Engine::Propagate;
+    if (propagating)
+        autoPencil(grid);
+
+    // expand level by level until there are a few subproblems per worker
+    vector<Grid> frontier(1, grid);
+    const size_t target = 8 * pool.size();
+    while (frontier.size() < target) {
+        vector<Grid> next;
+        for (Grid &g : frontier) {
+            stats.nodes++;
+            if (propagating && !propagate(g, stats))
+                continue;
+            int row, col;
+            bool found = propagating || branching == Branching::FewestCandidates ?
+                findFewestCandidates(g, row, col) :
+                findUnassignedLocation(g, row, col);
+            if (!found) {
+                grid = g; // solved before we even split
+                return true;
+            }
+            typename Grid::Mask cands = g.candidates(row, col);
+            while (cands) {
+                next.push_back(g);
+                place(next.back(), row, col, Grid::lowestDigit(cands));
+                cands &= cands - 1;
+            }
+        }
+        if (next.empty())
+            return false;
+        frontier.swap(next);
+    }
+
+    atomic<bool> stop(false);
+    mutex lock;
+    bool solved = false;
+    for (Grid &g : frontier) {
+        Grid *sub = &g; // each task owns one frontier grid
+        pool.submit([&, sub]() {
+            SearchStats local;
+            bool ok = propagating ? solvePropagating(*sub, local, &stop) :
+                                    solveSudoku(*sub, branching, local, &stop);
+            lock_guard<mutex> guard(lock);
+            stats.add(local);
+            if (ok && !solved) {
+                solved = true;
+                stop = true;
+                grid = *sub;
+            }
+        });
+    }
+    pool.wait();
+    return solved;
+}
+
+#define INSTANTIATE_SOLVER(B) \
+    template bool conflictingNumber(BasicSudokuGrid<B> &, int, int, int); \
+    template void autoPencil(BasicSudokuGrid<B> &); \
+    template void place(BasicSudokuGrid<B> &, int, int, int, DirtyUnits<B> *); \
+    template bool propagateUnits(BasicSudokuGrid<B> &, DirtyUnits<B> &, bool, \
+                                 SearchStats &); \
+    template void deduce(BasicSudokuGrid<B> &); \
+    template void deduce(BasicSudokuGrid<B> &, SearchStats &, unsigned); \
+    template bool findUnassignedLocation(BasicSudokuGrid<B> &, int &, int &); \
+    template bool findFewestCandidates(BasicSudokuGrid<B> &, int &, int &, \
+                                       SearchStats *); \
+    template bool solveSudoku(BasicSudokuGrid<B> &, Branching, SearchStats &, \
+                              const atomic<bool> *); \
+    template bool propagate(BasicSudokuGrid<B> &, SearchStats &); \
+    template bool solvePropagating(BasicSudokuGrid<B> &, SearchStats &, \
+                                   const atomic<bool> *); \
+    template bool consistentGivens(const BasicSudokuGrid<B> &); \
+    template SolutionFault checkSolution<B>(const char *, const char *, int &); \
+    template int countSolutions(BasicSudokuGrid<B> &, Engine, Branching, int, \
+                                SearchStats &); \
+    template bool solveParallel(BasicSudokuGrid<B> &, Engine, Branching, \
+                                ThreadPool &, SearchStats &);
+
+INSTANTIATE_SOLVER(2)
+INSTANTIATE_SOLVER(3)
+INSTANTIATE_SOLVER(4)
+INSTANTIATE_SOLVER(5)
@@ -0,0 +1,210 @@
+#ifndef SUDOKUSOLVER_H
+#define SUDOKUSOLVER_H
+
+#include <atomic>
+#include "SudokuGrid.h"
+
+class ThreadPool;
+
+/*  Which search engine main hands the deduced grid to */
+enum class Engine {
+    Backtrack,  // solveSudoku: plain chronological backtracking
+    Propagate,  // solvePropagating: singles propagated at every node
+    DLX,        // DancingLinks: exact cover with Knuth's Algorithm X
+    Iterative,  // IterativeSearch: Backtrack on an explicit stack
+    Lanes,      // LaneSolver: batches propagated in SIMD lanes, the
+                // rest solved as Backtrack
+    Learning    // LearningSearch: Backtrack with restarts and nogoods
+};
+
+/*  How solveSudoku (and IterativeSearch) picks the next empty cell to branch on */
+enum class Branching {
+    FirstEmpty,     // first empty cell in row-major order
+    FewestCandidates // minimum remaining values
+};
+
+/*  Elimination passes deduce() can chain after the singles, cheapest
+    first; a set of them is a bit mask of 1u << pass */
+enum DeducePass {
+    LockedCandidates,  // pointing and claiming (box/line reduction)
+    NakedSubsets,      // naked pairs and triples
+    HiddenSubsets,     // hidden pairs and triples
+    XWing,
+    DEDUCE_PASSES
+};
+const unsigned ALL_PASSES = (1u << DEDUCE_PASSES) - 1;
+extern const char *const DEDUCE_PASS_NAMES[DEDUCE_PASSES]; // "locked", ...
+
+/*  Extra instrumentation, compiled in only with -DSUDOKU_STATS (make
+    STATS=1): SUDOKU_STAT(x) evaluates x in such builds and is nothing
+    otherwise, so the plain build pays for none of it */
+#ifdef SUDOKU_STATS
+#define SUDOKU_STAT(x) (x)
+#else
+#define SUDOKU_STAT(x) ((void)0)
+#endif
+
+/*  Counters gathered during a search */
+struct SearchStats {
+    unsigned long nodes;
+    unsigned long propagations; // singles placed by propagate()
+    unsigned long eliminated[DEDUCE_PASSES]; // pencil marks each pass struck
+#ifdef SUDOKU_STATS
+    unsigned long guesses;      // digits tried at branch points
+    unsigned long backtracks;   // guesses taken back
+    unsigned long checks;       // candidate masks looked up to pick and fill cells
+    unsigned long deduced;      // singles placed by deduce()
+    int depth, maxDepth;        // search frames on the current path, and the most
+    double deduceMs, searchMs;  // time in each phase (filled in by callers)
+#endif
+    SearchStats() : nodes(0), propagations(0)
+#ifdef SUDOKU_STATS
+        , guesses(0), backtracks(0), checks(0), deduced(0), depth(0),
+        maxDepth(0), deduceMs(0), searchMs(0)
+#endif
+    {
+        for (int p = 0; p < DEDUCE_PASSES; p++) eliminated[p] = 0;
+    }
+
+    /*  Folds in the counters of another search (a subsearch or another
+        puzzle) */
+    void add(const SearchStats &other) {
+        nodes += other.nodes;
+        propagations += other.propagations;
+        for (int p = 0; p < DEDUCE_PASSES; p++) eliminated[p] += other.eliminated[p];
+#ifdef SUDOKU_STATS
+        guesses += other.guesses;
+        backtracks += other.backtracks;
+        checks += other.checks;
+        deduced += other.deduced;
+        if (other.maxDepth > maxDepth) maxDepth = other.maxDepth;
+        deduceMs += other.deduceMs;
+        searchMs += other.searchMs;
+#endif
+    }
+
+#ifdef SUDOKU_STATS
+    /*  Tracks the guess depth while a search frame is live */
+    struct Frame {
+        SearchStats &stats;
+        explicit Frame(SearchStats &stats) : stats(stats) {
+            if (++stats.depth > stats.maxDepth) stats.maxDepth = stats.depth;
+        }
+        ~Frame() { stats.depth--; }
+    };
+#endif
+};
+
+#ifdef SUDOKU_STATS
+#define SUDOKU_STAT_FRAME(stats) SearchStats::Frame statsFrame_(stats)
+#else
+#define SUDOKU_STAT_FRAME(stats) ((void)0)
+#endif
+
+/*  Work queue of units (rows 0..N-1, then columns, then blocks) whose
+    pencil marks changed since they were last scanned. It is a bit set,
+    so queueing is an OR and a unit is never queued twice; units come
+    off lowest number first */
+template <int B>
+class DirtyUnits {
+private:
+    static constexpr int N = B * B;
+    static constexpr int WORDS = (3 * N + 63) / 64;
+    uint64_t queued_[WORDS];
+public:
+    DirtyUnits() {
+        for (int w = 0; w < WORDS; w++) queued_[w] = 0;
+    }
+    bool empty() const {
+        for (int w = 0; w < WORDS; w++)
+            if (queued_[w]) return false;
+        return true;
+    }
+    void push(int u) { queued_[u / 64] |= 1ull << (u % 64); }
+    void pushAll() {
+        for (int u = 0; u < 3 * N; u++) push(u);
+    }
+    /*  Queues the row, column and block of cell k */
+    void touch(int k) {
+        const uint16_t *units = BasicSudokuGrid<B>::tables.cellUnits[k];
+        push(units[0]);
+        push(units[1]);
+        push(units[2]);
+    }
+    /*  Only call when not empty */
+    int pop() {
+        int w = 0;
+        while (queued_[w] == 0) w++;
+        int u = w * 64 + __builtin_ctzll(queued_[w]);
+        queued_[w] &= queued_[w] - 1;
+        return u;
+    }
+};
+
+template <int B>
+bool conflictingNumber(BasicSudokuGrid<B> &grid, int row, int col, int num);
+template <int B>
+void autoPencil(BasicSudokuGrid<B> &grid);
+template <int B>
+void place(BasicSudokuGrid<B> &grid, int row, int col, int n,
+           DirtyUnits<B> *dirty = nullptr);
+template <int B>
+bool propagateUnits(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty,
+                    bool nakedSingles, SearchStats &stats);
+template <int B>
+void deduce(BasicSudokuGrid<B> &grid);
+template <int B>
+void deduce(BasicSudokuGrid<B> &grid, SearchStats &stats, unsigned passes = 0);
+
+/*  The deduce() passes: each strikes what it can from the pencil marks
+    in one sweep of the grid, queues the units of every cell it changed
+    on dirty and returns the number of marks struck */
+template <int B>
+int lockedCandidates(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty);
+template <int B>
+int nakedSubsets(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty);
+template <int B>
+int hiddenSubsets(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty);
+template <int B>
+int xWing(BasicSudokuGrid<B> &grid, DirtyUnits<B> &dirty);
+
+template <int B>
+bool findUnassignedLocation(BasicSudokuGrid<B> &grid, int &row, int &col);
+template <int B>
+bool findFewestCandidates(BasicSudokuGrid<B> &grid, int &row, int &col,
+                          SearchStats *stats = nullptr);
+template <int B>
+bool solveSudoku(BasicSudokuGrid<B> &grid, Branching branching,
+                 SearchStats &stats, const std::atomic<bool> *stop = nullptr);
+
+template <int B>
+bool propagate(BasicSudokuGrid<B> &grid, SearchStats &stats);
+template <int B>
+bool solvePropagating(BasicSudokuGrid<B> &grid, SearchStats &stats,
+                      const std::atomic<bool> *stop = nullptr);
+
+template <int B>
+bool consistentGivens(const BasicSudokuGrid<B> &grid);
+
+/*  What checkSolution finds wrong with a solution, if anything */
+enum class SolutionFault {
+    None,
+    Bogus,   // a character that is neither a digit nor an empty cell
+    Empty,   // an empty cell
+    Givens,  // a cell that differs from the puzzle's given
+    Row,     // a unit that repeats a digit (and so misses another)
+    Column,
+    Box
+};
+
+template <int B>
+SolutionFault checkSolution(const char *puzzle, const char *solution, int &where);
+template <int B>
+int countSolutions(BasicSudokuGrid<B> &grid, Engine engine,
+                   Branching branching, int limit, SearchStats &stats);
+
+template <int B>
+bool solveParallel(BasicSudokuGrid<B> &grid, Engine engine,
+                   Branching branching, ThreadPool &pool, SearchStats &stats);
+
+#endif // SUDOKUSOLVER_H
@@ -0,0 +1,65 @@
+#ifndef SUDOKUTABLES_H
+#define SUDOKUTABLES_H
+
+#include <cstdint>
+
+/*  Lookup tables for an N x N board of B x B boxes, computed by the
+    compiler. Cells are numbered row-major (row * N + col) and units
+    are the N rows, then the N columns, then the N boxes, so that
+    walking a row, column, box or a cell's peers is a loop over a
+    flat index array with no division and no case analysis. */
+template <int B>
+struct SudokuTables {
+    static constexpr int N = B * B;
+    static constexpr int CELLS = N * N;
+    static constexpr int UNITS = 3 * N;
+    // cells sharing a unit with a cell: the rest of its row and
+    // column, plus the box cells in neither (20 for 9x9)
+    static constexpr int PEERS = 2 * (N - 1) + (B - 1) * (B - 1);
+
+    uint16_t unitCells[UNITS][N];
+    uint16_t peers[CELLS][PEERS];
+    uint16_t cellUnits[CELLS][3];  // row, column and box unit of a cell
+    uint8_t cellRow[CELLS];
+    uint8_t cellCol[CELLS];
+    uint8_t cellBox[CELLS];
+
+    constexpr SudokuTables()
+        : unitCells(), peers(), cellUnits(), cellRow(), cellCol(), cellBox() {
+        for (int k = 0; k < CELLS; k++) {
+            int r = k / N, c = k % N, b = (r / B) * B + c / B;
+            cellRow[k] = (uint8_t)r;
+            cellCol[k] = (uint8_t)c;
+            cellBox[k] = (uint8_t)b;
+            cellUnits[k][0] = (uint16_t)r;
+            cellUnits[k][1] = (uint16_t)(N + c);
+            cellUnits[k][2] = (uint16_t)(2 * N + b);
+        }
+        for (int u = 0; u < N; u++) {
+            for (int i = 0; i < N; i++) {
+                unitCells[u][i] = (uint16_t)(u * N + i);
+                unitCells[N + u][i] = (uint16_t)(i * N + u);
+                unitCells[2 * N + u][i] = (uint16_t)(((u / B) * B + i / B) * N +
+                                                     (u % B) * B + i % B);
+            }
+        }
+        for (int k = 0; k < CELLS; k++) {
+            int r = k / N, c = k % N, n = 0;
+            for (int i = 0; i < N; i++)
+                if (i != c) peers[k][n++] = (uint16_t)(r * N + i);
+            for (int i = 0; i < N; i++)
+                if (i != r) peers[k][n++] = (uint16_t)(i * N + c);
+            for (int i = 0; i < N; i++) {
+                int p = unitCells[2 * N + cellBox[k]][i];
+                if (p / N != r && p % N != c) peers[k][n++] = (uint16_t)p;
+            }
+        }
+    }
+};
+
+template <int B> constexpr int SudokuTables<B>::N;
+template <int B> constexpr int SudokuTables<B>::CELLS;
+template <int B> constexpr int SudokuTables<B>::UNITS;
+template <int B> constexpr int SudokuTables<B>::PEERS;
+
+#endif // SUDOKUTABLES_H
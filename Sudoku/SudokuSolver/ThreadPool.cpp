@@ -0,0 +1,98 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+namespace {
+    thread_local int workerIndex = -1;
+    thread_local const ThreadPool *workerPool = nullptr;
+}
+
+ThreadPool::ThreadPool(int threads) : queued_(0), unfinished_(0), sleepers_(0),
+                                      nextQueue_(0), stop_(false) {
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; i++)
+        queues_.emplace_back(new Queue);
+    for (int i = 0; i < threads; i++)
+        workers_.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+int ThreadPool::currentWorker() {
+    return workerIndex;
+}
+
+void ThreadPool::submit(Task task) {
+    int self = workerPool == this ? workerIndex : -1;
+    int q = self >= 0 ? self : (int)(nextQueue_++ % queues_.size());
+    unfinished_++;
+    {
+        std::lock_guard<std::mutex> qguard(queues_[q]->lock);
+        queues_[q]->tasks.push_back(std::move(task));
+        queued_++;
+    }
+    // a worker going to sleep counts itself in sleepers_ before it
+    // looks at queued_, so either it sees this task or we see it
+    if (sleepers_ > 0) {
+        std::lock_guard<std::mutex> guard(lock_);
+        wake_.notify_one();
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(lock_);
+    while (unfinished_ > 0)
+        idle_.wait(guard);
+}
+
+/*  Newest task from our own deque, else the oldest one we can steal */
+bool ThreadPool::pop(int self, Task &task) {
+    int n = (int)queues_.size();
+    for (int k = 0; k < n; k++) {
+        Queue &q = *queues_[(self + k) % n];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty()) continue;
+        if (k == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        queued_--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(int self) {
+    workerIndex = self;
+    workerPool = this;
+    for (;;) {
+        Task task;
+        if (!pop(self, task)) {
+            std::unique_lock<std::mutex> guard(lock_);
+            sleepers_++;
+            while (queued_ == 0 && !stop_)
+                wake_.wait(guard);
+            sleepers_--;
+            if (stop_ && queued_ == 0) return;
+            continue;
+        }
+        task();
+        if (--unfinished_ == 0) {
+            // wait() checks unfinished_ holding lock_, so it is asleep by now
+            std::lock_guard<std::mutex> guard(lock_);
+            idle_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*  Fixed set of worker threads, each with its own task deque. A worker
+    pops the newest task off its own deque and, when that runs dry,
+    steals the oldest task from another worker's deque. Tasks may
+    submit further tasks; those land on the submitting worker's deque. */
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    explicit ThreadPool(int threads = 0);  // 0: one per hardware thread
+    ~ThreadPool();
+
+    void submit(Task task);
+    void wait();  // until every submitted task has run
+    int size() const { return (int)workers_.size(); }
+
+    /*  Index of the calling worker in [0, size()), -1 if the caller
+        is not a worker of any pool */
+    static int currentWorker();
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex lock_;                   // only for going to sleep and waking up
+    std::condition_variable wake_;      // tasks queued or stopping
+    std::condition_variable idle_;      // unfinished_ dropped to zero
+    std::atomic<long> queued_;          // tasks sitting in some deque
+    std::atomic<long> unfinished_;      // submitted but not yet run
+    std::atomic<int> sleepers_;         // workers waiting on wake_
+    std::atomic<unsigned long> nextQueue_;
+    bool stop_;                         // under lock_
+
+    bool pop(int self, Task &task);
+    void run(int self);
+};
+
+/*  Hands results produced out of order back in sequence order */
+class ReorderBuffer {
+public:
+    ReorderBuffer() : next_(0) {}
+
+    void put(unsigned long seq, std::string result) {
+        std::lock_guard<std::mutex> guard(lock_);
+        ready_[seq] = std::move(result);
+        if (seq == next_) ready_cv_.notify_all();
+    }
+
+    /*  Moves the next result in sequence into out, waiting for it if
+        wait is set; returns false if it is not ready */
+    bool take(std::string &out, bool wait) {
+        std::unique_lock<std::mutex> guard(lock_);
+        auto iter = ready_.find(next_);
+        while (iter == ready_.end()) {
+            if (!wait) return false;
+            ready_cv_.wait(guard);
+            iter = ready_.find(next_);
+        }
+        out = std::move(iter->second);
+        ready_.erase(iter);
+        next_++;
+        return true;
+    }
+
+private:
+    std::mutex lock_;
+    std::condition_variable ready_cv_;
+    std::map<unsigned long, std::string> ready_;
+    unsigned long next_;
+};
+
+#endif // THREADPOOL_H
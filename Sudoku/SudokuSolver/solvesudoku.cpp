@@ -1,329 +1,1037 @@
 #include <string>
 #include <iostream>
+#include <fstream>
 #include <algorithm>
-#include "SudokuGrid.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "SudokuSolver.h"
+#include "DancingLinks.h"
+#include "IterativeSearch.h"
+#include "LaneSolver.h"
+#include "LearningSearch.h"
+#include "PuzzleFile.h"
+#include "SolutionCache.h"
+#include "SolverSocket.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
-/*  Finds if there is a conflicting number in either the row column
-    or block if it finds one, return true else false */
-bool conflictingNumber(SudokuGrid &grid, int row, int col, int num) {
-    for (int i = 0; i < 9; i++) {
-        if (grid.number(i, col) == num) return true;
-    }
+/*  How --stats reports the instrumentation counters */
+enum class StatsFormat { None, Line, JSON };
+
+/*  Command line settings */
+struct Options {
+    Engine engine;
+    Branching branching;
+    int boxSize;
+    int threads;
+    bool verbose;
+    bool batch;
+    bool count;  // count solutions instead of solving
+    bool validate;  // check puzzle/solution pairs instead of solving
+    int limit;   // stop counting at this many
+    StatsFormat stats;
+    unsigned passes;  // deduce() passes to run, 1u << DeducePass
+    size_t cacheSize;       // solved puzzles kept by canonical form, 0: none
+    const char *cacheFile;  // where the cache is loaded from and saved to
+    const char *serve;      // socket to answer puzzles on
+    const char *file;
+    Options() : engine(Engine::Backtrack), branching(Branching::FirstEmpty),
+                boxSize(3), threads(1), verbose(false), batch(false),
+                count(false), validate(false), limit(2), stats(StatsFormat::None),
+                passes(ALL_PASSES), cacheSize(0), cacheFile(nullptr),
+                serve(nullptr), file(nullptr) {}
+};
 
-    for (int i = 0; i < 9; i++) {
-        if (grid.number(row, i) == num) return true;
+#ifdef SUDOKU_STATS
+static double msSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/*  Writes the instrumentation counters for puzzles puzzles to stderr,
+    as one line or as one JSON object */
+static void printStats(const SearchStats &stats, unsigned long puzzles,
+                       StatsFormat format) {
+    if (format == StatsFormat::JSON) {
+        cerr << "{\"puzzles\":" << puzzles << ",\"nodes\":" << stats.nodes
+             << ",\"guesses\":" << stats.guesses
+             << ",\"backtracks\":" << stats.backtracks
+             << ",\"max_depth\":" << stats.maxDepth
+             << ",\"deduced\":" << stats.deduced
+             << ",\"propagations\":" << stats.propagations
+             << ",\"checks\":" << stats.checks
+             << ",\"deduce_ms\":" << stats.deduceMs
+             << ",\"search_ms\":" << stats.searchMs << "}" << endl;
+    } else if (format == StatsFormat::Line) {
+        cerr << "stats: " << puzzles << " puzzles, " << stats.nodes << " nodes, "
+             << stats.guesses << " guesses, " << stats.backtracks
+             << " backtracks, max depth " << stats.maxDepth << ", "
+             << stats.deduced << " deduced, " << stats.propagations
+             << " propagations, " << stats.checks << " checks, deduce "
+             << stats.deduceMs << " ms, search " << stats.searchMs << " ms"
+             << endl;
     }
+}
+#endif
 
-    if (0 <= row && row <= 2) {
-        /* .##
-           ###
-           ### */
-        if (0 <= col && col <= 2) {
-            for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 3; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
-            }
-            /* #.#
-               ###
-               ### */
-        } else if (3 <= col && col <= 5) {
-            for (int i = 0; i < 3; i++) {
-                for (int j = 3; j < 6; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
-            }
-            /* ##.
-               ###
-               ### */
-        } else {
-            for (int i = 0; i < 3; i++) {
-                for (int j = 6; j < 9; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
+/*  Prints out the grid, built up in a buffer and written at once */
+template <int B>
+void printGrid(const BasicSudokuGrid<B> &grid) {
+    const int N = B * B;
+    // a row of cells or a rule is at most 4N characters and a newline
+    char buf[(4 * N + 2) * (N + B) + 2];
+    char *p = buf;
+    for (int k = 0; k < N * N; k++) {
+        if (k == 0) {
+            *p++ = '\n';
+        } else if (k % (B * N) == 0) {
+            // a box is B cells of "d " plus "| " between boxes
+            *p++ = '\n';
+            for (int b = 0; b < B; b++) {
+                if (b > 0) *p++ = '+';
+                int dashes = b == 0 || b == B - 1 ? 2 * B : 2 * B + 1;
+                p = fill_n(p, dashes, '-');
             }
+            *p++ = '\n';
+        } else if (k % N == 0) {
+            *p++ = '\n';
+        } else if (k % B == 0) {
+            *p++ = '|';
+            *p++ = ' ';
+        }
+        *p++ = BasicSudokuGrid<B>::digitChar(grid.number(k));
+        *p++ = ' ';
+    }
+    *p++ = '\n';
+    std::cout.write(buf, p - buf);
+}
+
+/*  True if s has one '.' or digit character per cell */
+template <int B>
+bool isPuzzle(const std::string &s) {
+    return s.length() == (size_t)BasicSudokuGrid<B>::CELLS &&
+        all_of(s.begin(), s.end(), BasicSudokuGrid<B>::isDigitChar);
+}
+
+/*  State a solve can reuse from one puzzle to the next */
+template <int B>
+struct SolverScratch {
+    DancingLinks<B> dlx;
+    LaneSolver<B> lanes;
+    LearningSearch<B> learning;
+    SearchStats stats;
+    unsigned long unsolved;
+    unsigned long unique, multiple;  // --count results
+    unsigned long cacheHits, uncacheable;
+    unsigned long laneSolved;  // puzzles finished by the lanes engine
+    SolverScratch() : unsolved(0), unique(0), multiple(0), cacheHits(0),
+                      uncacheable(0), laneSolved(0) {}
+};
+
+/*  Deduces what it can and hands the rest to the chosen engine; false
+    if it has no solution */
+template <int B>
+bool solvePuzzle(BasicSudokuGrid<B> &grid, const Options &opt,
+                 SolverScratch<B> &scratch) {
+    // a clash among the givens could keep a search busy for ages, and
+    // a full grid with one would pass for its own solution
+    if (!consistentGivens(grid))
+        return false;
+#ifdef SUDOKU_STATS
+    auto start = chrono::steady_clock::now();
+#endif
+    deduce(grid, scratch.stats, opt.passes);
+    SUDOKU_STAT(scratch.stats.deduceMs += msSince(start));
+    SUDOKU_STAT(start = chrono::steady_clock::now());
+    bool solved;
+    if (opt.engine == Engine::Propagate)
+        solved = solvePropagating(grid, scratch.stats);
+    else if (opt.engine == Engine::DLX)
+        solved = scratch.dlx.solve(grid, scratch.stats) > 0;
+    else if (opt.engine == Engine::Iterative)
+        solved = solveIterative(grid, opt.branching, scratch.stats);
+    else if (opt.engine == Engine::Learning)
+        solved = scratch.learning.solve(grid, opt.branching, scratch.stats);
+    else
+        solved = solveSudoku(grid, opt.branching, scratch.stats);
+    SUDOKU_STAT(scratch.stats.searchMs += msSince(start));
+    return solved;
+}
+
+/*  Solves grid through the cache: a puzzle with the canonical form of
+    one solved before is mapped back from the stored solution without
+    any search, and a newly solved one has its solution stored in
+    canonical form. Puzzles too symmetric to canonicalize are solved as
+    usual */
+template <int B>
+bool solveCached(BasicSudokuGrid<B> &grid, const Options &opt,
+                 SolverScratch<B> &scratch, SolutionCache<B> &cache) {
+    Symmetry<B> sym;
+    typename Symmetry<B>::Cells canon, solution;
+    if (!canonicalize(grid, sym, canon)) {
+        scratch.uncacheable++;
+        return solvePuzzle(grid, opt, scratch);
+    }
+    if (cache.lookup(canon, solution)) {
+        sym.unapply(solution, grid);
+        scratch.cacheHits++;
+        return true;
+    }
+    if (!solvePuzzle(grid, opt, scratch))
+        return false;
+    // a full grid with no clash is a solution; anything else would be
+    // served to every symmetric copy of the puzzle, so keep it out
+    if (consistentGivens(grid)) {
+        sym.apply(grid, solution);
+        cache.insert(canon, solution);
+    }
+    return true;
+}
+
+/*  Counts the solutions of a puzzle up to opt.limit, leaving the grid
+    as the first one found. DLX counts on the scratch links, the other
+    engines on the stack, so nothing is allocated per puzzle */
+template <int B>
+int countPuzzle(BasicSudokuGrid<B> &grid, const Options &opt,
+                SolverScratch<B> &scratch) {
+    if (!consistentGivens(grid))
+        return 0;
+#ifdef SUDOKU_STATS
+    auto start = chrono::steady_clock::now();
+#endif
+    deduce(grid, scratch.stats, opt.passes);
+    SUDOKU_STAT(scratch.stats.deduceMs += msSince(start));
+    SUDOKU_STAT(start = chrono::steady_clock::now());
+    int solutions;
+    if (opt.engine == Engine::DLX)
+        solutions = scratch.dlx.solve(grid, scratch.stats, opt.limit);
+    else
+        solutions = countSolutions(grid, opt.engine, opt.branching, opt.limit,
+                                   scratch.stats);
+    SUDOKU_STAT(scratch.stats.searchMs += msSince(start));
+    return solutions;
+}
+
+/*  Appends "<solutions> <nodes>" for one counted puzzle */
+template <int B>
+void countLine(BasicSudokuGrid<B> &grid, string &out, const Options &opt,
+               SolverScratch<B> &scratch) {
+    unsigned long nodes = scratch.stats.nodes;
+    int solutions = countPuzzle(grid, opt, scratch);
+    if (solutions == 0) scratch.unsolved++;
+    else if (solutions == 1) scratch.unique++;
+    else scratch.multiple++;
+    out += to_string(solutions);
+    out.push_back(' ');
+    out += to_string(scratch.stats.nodes - nodes);
+    out.push_back('\n');
+}
+
+/*  A chunk of validated puzzle lines, kept back to back in one buffer
+    that is reused from chunk to chunk */
+template <int B>
+struct TextChunk {
+    typedef BasicSudokuGrid<B> Grid;
+    string text;
+    size_t size() const { return text.size() / Grid::CELLS; }
+    void add(const string &line) { text += line; }
+    void clear() { text.clear(); }
+    Grid grid(size_t i) const { return Grid(text.data() + i * Grid::CELLS); }
+    void echo(size_t i, string &out) const {
+        out.append(text, i * Grid::CELLS, Grid::CELLS);
+        out.push_back('\n');
+    }
+};
+
+/*  A run of good records of a packed puzzle file, read where they
+    are mapped */
+template <int B>
+struct PackedChunk {
+    const MappedPuzzleFile *file;
+    uint64_t first, count;
+    size_t size() const { return count; }
+    BasicSudokuGrid<B> grid(size_t i) const {
+        BasicSudokuGrid<B> grid;
+        unpackGrid(file->record(first + i), grid);  // solvePacked left out bad ones
+        return grid;
+    }
+    void echo(size_t i, string &out) const { formatGrid(grid(i), out); }
+};
+
+/*  Solves a chunk of puzzles, appending one output line per puzzle to
+    out (unsolvable puzzles are echoed back unchanged, counted ones get
+    their count line). Solving goes through cache if there is one */
+template <int B, class Chunk>
+void solveChunk(const Chunk &puzzles, string &out, const Options &opt,
+                SolverScratch<B> &scratch, SolutionCache<B> *cache) {
+    const int LANES = LaneSolver<B>::LANES;
+    unsigned laneSolved = 0, laneClashed = 0;
+    for (size_t i = 0; i < puzzles.size(); i++) {
+        BasicSudokuGrid<B> grid = puzzles.grid(i);
+        if (opt.count) {
+            countLine(grid, out, opt, scratch);
+            continue;
         }
-        /* ###
-           .##
-           ### */
-    } else if (3 <= row && row <= 5) {
-        if (0 <= col && col <= 2) {
-            for (int i = 3; i < 6; i++) {
-                for (int j = 0; j < 3; j++) {
-                    if (grid.number(i, j) == num) return true;
+        if (opt.engine == Engine::Lanes) {
+            // start the next LANES puzzles together; one whose givens
+            // clash stays out, leaving its lane empty, and is never
+            // handed on to a search
+            if (i % LANES == 0) {
+                scratch.lanes.clear();
+                laneClashed = 0;
+                for (size_t l = 0; l < (size_t)LANES && i + l < puzzles.size(); l++) {
+                    BasicSudokuGrid<B> lane = l ? puzzles.grid(i + l) : grid;
+                    if (consistentGivens(lane))
+                        scratch.lanes.load((int)l, lane);
+                    else
+                        laneClashed |= 1u << l;
                 }
+                laneSolved = scratch.lanes.run();
             }
-            /* ###
-               #.#
-               ### */
-        } else if (3 <= col && col <= 5) {
-            for (int i = 3; i < 6; i++) {
-                for (int j = 3; j < 6; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
+            if (laneClashed >> (i % LANES) & 1) {
+                puzzles.echo(i, out);
+                scratch.unsolved++;
+                continue;
             }
-            /* ###
-               ##.
-               ### */
-        } else {
-            for (int i = 3; i < 6; i++) {
-                for (int j = 6; j < 9; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
+            if (laneSolved >> (i % LANES) & 1) {
+                scratch.lanes.store((int)(i % LANES), grid);
+                scratch.laneSolved++;
+                formatGrid(grid, out);
+                continue;
             }
         }
-        /* ###
-           ###
-           .## */
-    } else {
-        if (0 <= col && col <= 2) {
-            for (int i = 6; i < 9; i++) {
-                for (int j = 0; j < 3; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
-            }
-            /* ###
-               ###
-               #.# */
-        } else if (3 <= col && col <= 5) {
-            for (int i = 6; i < 9; i++) {
-                for (int j = 3; j < 6; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
-            }
-            /* ###
-               ###
-               ##. */
+        bool solved = cache ? solveCached(grid, opt, scratch, *cache)
+                            : solvePuzzle(grid, opt, scratch);
+        if (solved) {
+            formatGrid(grid, out);
         } else {
-            for (int i = 6; i < 9; i++) {
-                for (int j = 6; j < 9; j++) {
-                    if (grid.number(i, j) == num) return true;
-                }
-            }
+            puzzles.echo(i, out);
+            scratch.unsolved++;
         }
     }
-    return false;
 }
 
-/*  Pencils in all possibilities for each cell in the grid 
-    by set all 9 pencils and then removing conflicting pencils */
-void autoPencil(SudokuGrid &grid) {
-    for (int r = 0; r < 9; r++) {
-        for (int c = 0; c < 9; c++) {
-            if (grid.number(r, c) == 0) {
-                grid.setAllPencils(r, c);
-                for (int n = 1; n <= 9; n++) {
-                    if (conflictingNumber(grid, r, c, n)) {
-                        grid.clearPencil(r, c, n);
-                    }
-                }
-            }
+/*  The cache -C and --cache-file ask for, loaded from the file if
+    there is one; null without -C or when counting */
+template <int B>
+unique_ptr<SolutionCache<B>> openCache(const Options &opt) {
+    unique_ptr<SolutionCache<B>> cache;
+    if (opt.cacheSize != 0 && !opt.count) {
+        cache.reset(new SolutionCache<B>(opt.cacheSize));
+        string error;
+        if (opt.cacheFile != nullptr && !cache->load(opt.cacheFile, error)) {
+            cerr << opt.cacheFile << ": " << error << endl;
+            exit(1);
         }
     }
+    return cache;
 }
 
-/*  Counts the number of times the pencil n appears in the given row */
-int numPencilsInRow(SudokuGrid &grid, int row, int n) {
-    int count = 0;
-    for (int i = 0; i < 9; i++) {
-        if (grid.isPencilSet(row, i, n)) count++;
+const size_t CHUNK = 256;  // puzzles per task
+
+/*  Solves chunks of puzzles and writes each solution as one compact
+    line, in input order. With more than one thread, chunks are solved
+    on a work-stealing pool, each worker with its own scratch, and put
+    back in order through a reorder buffer. */
+template <int B>
+class BatchSolver {
+public:
+    explicit BatchSolver(const Options &opt)
+        : opt_(opt), submitted_(0), written_(0),
+          start_(chrono::steady_clock::now()) {
+        out_.reserve(CHUNK * (BasicSudokuGrid<B>::CELLS + 1));
+        if (opt.threads != 1)
+            pool_.reset(new ThreadPool(opt.threads));
+        workers_ = pool_ ? pool_->size() : 1;
+        for (int i = 0; i < workers_; i++)
+            scratch_.emplace_back(new SolverScratch<B>);
+        cache_ = openCache<B>(opt);
+    }
+
+    /*  Solves chunk, which the caller may clear and refill afterwards.
+        With one thread nothing is allocated: the chunk is solved where
+        it is, into an output buffer kept from the last one */
+    template <class Chunk>
+    void solve(Chunk &chunk) {
+        if (!pool_) {
+            out_.clear();
+            solveChunk(chunk, out_, opt_, *scratch_[0], cache_.get());
+            cout.write(out_.data(), out_.size());
+            return;
+        }
+        auto work = make_shared<Chunk>(chunk);  // the caller keeps its buffer
+        unsigned long seq = submitted_++;
+        pool_->submit([this, work, seq]() {
+            string solved;
+            solveChunk(*work, solved, opt_, *scratch_[ThreadPool::currentWorker()],
+                       cache_.get());
+            results_.put(seq, std::move(solved));
+        });
+        // write whatever is ready; block once too many chunks are in flight
+        while (written_ < submitted_ &&
+               results_.take(out_, submitted_ - written_ > 4 * (unsigned long)workers_)) {
+            cout.write(out_.data(), out_.size());
+            written_++;
+        }
     }
-    return count;
+
+    /*  Writes what is left and the summary for puzzles puzzles */
+    void finish(unsigned long puzzles) {
+        while (written_ < submitted_ && results_.take(out_, true)) {
+            cout.write(out_.data(), out_.size());
+            written_++;
+        }
+        cout.flush();
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start_).count();
+
+        SearchStats total;
+        unsigned long unsolved = 0, unique = 0, multiple = 0;
+        unsigned long cacheHits = 0, uncacheable = 0, laneSolved = 0;
+        unsigned long restarts = 0, pruned = 0;
+        for (auto &s : scratch_) {
+            total.add(s->stats);
+            unsolved += s->unsolved;
+            unique += s->unique;
+            multiple += s->multiple;
+            cacheHits += s->cacheHits;
+            uncacheable += s->uncacheable;
+            laneSolved += s->laneSolved;
+            restarts += s->learning.restarts();
+            pruned += s->learning.pruned();
+        }
+        cerr << puzzles << " puzzles in " << secs << " s ("
+             << (secs > 0 ? puzzles / secs : 0) << " puzzles/sec";
+        if (pool_) cerr << ", " << workers_ << " threads";
+        cerr << ")";
+        if (opt_.count) {
+            cerr << ", " << unique << " unique, " << multiple << " multiple, "
+                 << unsolved << " unsolvable";
+        } else if (unsolved) {
+            cerr << ", " << unsolved << " unsolved";
+        }
+        if (cache_) {
+            cerr << ", " << cacheHits << " cache hits";
+            if (opt_.verbose) cerr << " (" << uncacheable << " uncacheable)";
+        }
+        if (opt_.engine == Engine::Lanes && !opt_.count)
+            cerr << ", " << laneSolved << " solved in lanes";
+        if (opt_.verbose) {
+            cerr << ", " << total.nodes << " nodes, "
+                 << total.propagations << " propagations, eliminated";
+            for (int p = 0; p < DEDUCE_PASSES; p++)
+                cerr << (p ? ", " : " ") << DEDUCE_PASS_NAMES[p] << " "
+                     << total.eliminated[p];
+            if (opt_.engine == Engine::Learning)
+                cerr << ", " << restarts << " restarts, " << pruned << " nogood prunes";
+        }
+        cerr << endl;
+        SUDOKU_STAT(printStats(total, puzzles, opt_.stats));
+
+        string error;
+        if (cache_ && opt_.cacheFile != nullptr && !cache_->save(opt_.cacheFile, error))
+            cerr << opt_.cacheFile << ": " << error << endl;
+    }
+
+private:
+    const Options &opt_;
+    ReorderBuffer results_;
+    vector<unique_ptr<SolverScratch<B>>> scratch_;
+    unique_ptr<ThreadPool> pool_;
+    unique_ptr<SolutionCache<B>> cache_;
+    int workers_;
+    unsigned long submitted_, written_;
+    string out_;
+    chrono::steady_clock::time_point start_;
+};
+
+/*  Solves every puzzle in the stream, one per line. Blank lines are
+    skipped and bogus ones reported */
+template <int B>
+void solveBatch(istream &in, const Options &opt) {
+    BatchSolver<B> batch(opt);
+    unsigned long lineno = 0, puzzles = 0;
+    TextChunk<B> chunk;
+    chunk.text.reserve(CHUNK * BasicSudokuGrid<B>::CELLS);
+    string line;
+    while (getline(in, line)) {
+        lineno++;
+        // tolerate CRLF endings and the ^Z DOS end-of-file marker
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\x1a'))
+            line.pop_back();
+        if (line.empty()) continue;
+        if (!isPuzzle<B>(line)) {
+            cerr << "line " << lineno << ": bogus puzzle!" << endl;
+            continue;
+        }
+        chunk.add(line);
+        puzzles++;
+        if (chunk.size() == CHUNK) {
+            batch.solve(chunk);
+            chunk.clear();
+        }
+    }
+    if (chunk.size() > 0) batch.solve(chunk);
+    batch.finish(puzzles);
 }
-/*  Counts the number of times pencil n appears in the given column */
-int numPencilsInColumn(SudokuGrid &grid, int col, int n) {
-    int count = 0;
-    for (int i = 0; i < 9; i++) {
-        if (grid.isPencilSet(i, col, n)) count++;
+
+/*  Solves every puzzle of a packed file, straight from the mapping.
+    Damaged records are reported and skipped, as bogus lines are */
+template <int B>
+void solvePacked(const MappedPuzzleFile &file, const Options &opt) {
+    BatchSolver<B> batch(opt);
+    unsigned long puzzles = 0;
+    PackedChunk<B> chunk{&file, 0, 0};
+    for (uint64_t i = 0; i < file.count(); i++) {
+        if (!goodRecord<B>(file.record(i))) {
+            cerr << "record " << i + 1 << ": bogus puzzle!" << endl;
+            // a chunk is a run of records: end this one before the bad one
+            if (chunk.count > 0) batch.solve(chunk);
+            chunk = PackedChunk<B>{&file, i + 1, 0};
+            continue;
+        }
+        puzzles++;
+        if (++chunk.count == CHUNK) {
+            batch.solve(chunk);
+            chunk = PackedChunk<B>{&file, i + 1, 0};
+        }
     }
-    return count;
+    if (chunk.count > 0) batch.solve(chunk);
+    batch.finish(puzzles);
 }
-/*  Counts the number of times pencil n appears in the given block */
-int numPencilsInBlock(SudokuGrid &grid, int row, int col, int n) {
-    int count = 0;
-    if (0 <= row && row <= 2) {
-        /* .##
-           ###
-           ### */
-        if (0 <= col && col <= 2) {
-            for (int i = 0; i < 3; i++) {
-                for (int j = 0; j < 3; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
-            }
-            /* #.#
-               ###
-               ### */
-        } else if (3 <= col && col <= 5) {
-            for (int i = 0; i < 3; i++) {
-                for (int j = 3; j < 6; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
-            }
-            /* ##.
-               ###
-               ### */
-        } else {
-            for (int i = 0; i < 3; i++) {
-                for (int j = 6; j < 9; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
-            }
+
+/*  Write end of the pipe that wakes the server up on SIGINT or SIGTERM */
+static int stopPipe = -1;
+
+static void stopServing(int) {
+    char c = 0;
+    ssize_t ignored = write(stopPipe, &c, 1);
+    (void)ignored;
+}
+
+/*  solvesudoku --serve: answers puzzles sent over a Unix socket (the
+    protocol is in SolverSocket.h) until SIGINT or SIGTERM. The pool,
+    each worker's scratch and the cache are all set up before the first
+    connection comes in. Every connection gets a thread that reads its
+    requests and hands them to the pool, then writes the replies back in
+    order, as many to a write as are ready. */
+template <int B>
+class SolverServer {
+public:
+    explicit SolverServer(const Options &opt)
+        : opt_(opt), pool_(opt.threads), cache_(openCache<B>(opt)),
+          connections_(0), served_(0) {
+        for (int i = 0; i < pool_.size(); i++)
+            scratch_.emplace_back(new SolverScratch<B>);
+    }
+
+    int run(const char *path) {
+        string error;
+        int listener = listenUnix(path, error);
+        int wake[2];
+        if (listener < 0 || pipe(wake) < 0) {
+            cerr << path << ": " << (listener < 0 ? error : strerror(errno)) << endl;
+            return 1;
         }
-        /* ###
-           .##
-           ### */
-    } else if (3 <= row && row <= 5) {
-        if (0 <= col && col <= 2) {
-            for (int i = 3; i < 6; i++) {
-                for (int j = 0; j < 3; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
-            }
-            /* ###
-               #.#
-               ### */
-        } else if (3 <= col && col <= 5) {
-            for (int i = 3; i < 6; i++) {
-                for (int j = 3; j < 6; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
-            }
-            /* ###
-               ##.
-               ### */
-        } else {
-            for (int i = 3; i < 6; i++) {
-                for (int j = 6; j < 9; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
+        stopPipe = wake[1];
+        signal(SIGINT, stopServing);
+        signal(SIGTERM, stopServing);
+        auto start = chrono::steady_clock::now();
+        cerr << "serving on " << path << " with " << pool_.size() << " threads" << endl;
+
+        for (;;) {
+            pollfd wait[2] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+            if (poll(wait, 2, -1) < 0 && errno != EINTR)
+                break;
+            if (wait[1].revents != 0)
+                break;
+            if (wait[0].revents & POLLIN) {
+                int fd = accept(listener, nullptr, nullptr);
+                if (fd < 0) continue;
+                lock_guard<mutex> guard(lock_);
+                open_.insert(fd);
+                connections_++;
+                thread([this, fd]() { serve(fd); }).detach();
             }
         }
-        /* ###
-           ###
-           .## */
-    } else {
-        if (0 <= col && col <= 2) {
-            for (int i = 6; i < 9; i++) {
-                for (int j = 0; j < 3; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
-            }
-            /* ###
-               ###
-               #.# */
-        } else if (3 <= col && col <= 5) {
-            for (int i = 6; i < 9; i++) {
-                for (int j = 3; j < 6; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
+        close(listener);
+        unlink(path);
+        {
+            // hang up on the clients still connected and let their
+            // threads wind down
+            unique_lock<mutex> guard(lock_);
+            for (int fd : open_)
+                shutdown(fd, SHUT_RDWR);
+            closed_.wait(guard, [this]() { return open_.empty(); });
+        }
+        close(wake[0]);
+        close(wake[1]);
+
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        unsigned long unsolved = 0, cacheHits = 0;
+        for (auto &s : scratch_) {
+            unsolved += s->unsolved;
+            cacheHits += s->cacheHits;
+        }
+        cerr << served_ << " puzzles on " << connections_ << " connections in "
+             << secs << " s";
+        if (unsolved) cerr << ", " << unsolved << " unsolved";
+        if (cache_) cerr << ", " << cacheHits << " cache hits";
+        cerr << endl;
+        if (cache_ && opt_.cacheFile != nullptr && !cache_->save(opt_.cacheFile, error))
+            cerr << opt_.cacheFile << ": " << error << endl;
+        return 0;
+    }
+
+private:
+    const Options &opt_;
+    ThreadPool pool_;
+    vector<unique_ptr<SolverScratch<B>>> scratch_;
+    unique_ptr<SolutionCache<B>> cache_;
+    mutex lock_;
+    condition_variable closed_;  // a connection left open_
+    set<int> open_;              // connected sockets
+    unsigned long connections_;
+    atomic<unsigned long> served_;
+
+    /*  The reply payload for one request */
+    string answer(const string &request, SolverScratch<B> &scratch) {
+        if (!isPuzzle<B>(request))
+            return SolverProtocol::ERROR + string("bogus puzzle");
+        BasicSudokuGrid<B> grid(request.data());
+        served_++;
+        bool solved = cache_ ? solveCached(grid, opt_, scratch, *cache_)
+                             : solvePuzzle(grid, opt_, scratch);
+        if (!solved) {
+            scratch.unsolved++;
+            return string(1, SolverProtocol::UNSOLVABLE);
+        }
+        string reply(1, SolverProtocol::SOLVED);
+        formatGrid(grid, reply);
+        reply.pop_back();  // frames need no newline
+        return reply;
+    }
+
+    /*  Runs one connection until the client hangs up */
+    void serve(int fd) {
+        FrameReader in(fd);
+        ReorderBuffer replies;
+        unsigned long submitted = 0, written = 0;
+        string request, reply, out;
+        for (;;) {
+            // before waiting on the client for more, answer all it has
+            // asked so far
+            bool drain = !in.ready();
+            out.clear();
+            while (written < submitted && replies.take(reply, drain)) {
+                appendFrame(out, reply);
+                written++;
             }
-            /* ###
-               ###
-               ##. */
-        } else {
-            for (int i = 6; i < 9; i++) {
-                for (int j = 6; j < 9; j++) {
-                    if (grid.isPencilSet(i, j, n)) count++;
-                }
+            if (!out.empty() && !writeAll(fd, out))
+                break;
+            FrameReader::Result got = in.next(request);
+            if (got == FrameReader::Result::Bad) {
+                out.clear();
+                appendFrame(out, SolverProtocol::ERROR + string("bad frame"));
+                writeAll(fd, out);
             }
+            if (got != FrameReader::Result::Frame)
+                break;
+            unsigned long seq = submitted++;
+            pool_.submit([this, &replies, seq, request]() {
+                replies.put(seq, answer(request, *scratch_[ThreadPool::currentWorker()]));
+            });
         }
+        // the pool may still be working for this connection
+        while (written < submitted && replies.take(reply, true))
+            written++;
+        lock_guard<mutex> guard(lock_);
+        open_.erase(fd);
+        close(fd);
+        closed_.notify_all();
+    }
+};
+
+/*  What -V reports for a fault checkSolution found at where */
+template <int B>
+string describeFault(SolutionFault fault, int where) {
+    const int N = BasicSudokuGrid<B>::N;
+    string cell = "row " + to_string(where / N + 1) + ", column " + to_string(where % N + 1);
+    switch (fault) {
+    case SolutionFault::Bogus: return "bogus character at " + cell;
+    case SolutionFault::Empty: return "empty cell at " + cell;
+    case SolutionFault::Givens: return "given changed at " + cell;
+    case SolutionFault::Row: return "row " + to_string(where + 1) + " repeats a digit";
+    case SolutionFault::Column: return "column " + to_string(where + 1) + " repeats a digit";
+    case SolutionFault::Box: return "box " + to_string(where + 1) + " repeats a digit";
+    default: return "ok";
     }
-    return count;
 }
 
-/*  Deductively solves a few places on the grid to lighten the load 
-    for solve, it does this by finding pencils that have no conflicting
-    pencil marks */
-void deduce(SudokuGrid &grid) {
-    bool changed;
-    do { // repeat until no changes made
-        autoPencil(grid);
-        changed = false;
-        for (int row = 0; row < 9; row++)
-            for (int col = 0; col < 9; col++)
-                for (int n = 1; n <= 9; n++)
-                    if (grid.isPencilSet(row, col, n) &&
-                        (numPencilsInRow(grid, row, n) == 1 ||
-                         numPencilsInColumn(grid, col, n) == 1 ||
-                         numPencilsInBlock(grid, row, col, n) == 1)) {
-                        grid.clearAllPencils(row, col);
-                        grid.setNumber(row, col, n);
-                        grid.setSolved(row, col);
-                        autoPencil(grid);
-                        changed = true;
-                        break;
-                    }
-    } while (changed);
+/*  Checks one "puzzle solution" line (from p up to end); empty if the
+    solution holds */
+template <int B>
+string checkPair(const char *p, const char *end) {
+    const size_t CELLS = BasicSudokuGrid<B>::CELLS;
+    auto blank = [](char c) { return c == ' ' || c == '\t'; };
+    const char *puzzle = p;
+    while (p < end && !blank(*p)) p++;
+    const char *puzzleEnd = p;
+    while (p < end && blank(*p)) p++;
+    if ((size_t)(puzzleEnd - puzzle) != CELLS || (size_t)(end - p) != CELLS)
+        return "bogus pair!";
+    int where;
+    SolutionFault fault = checkSolution<B>(puzzle, p, where);
+    return fault == SolutionFault::None ? string() : describeFault<B>(fault, where);
 }
 
-/*  Finds cells that do not have a proper value and gives the saves the row
-    col */
-bool findUnassignedLocation(SudokuGrid &grid, int &row, int &col) {
-    for (int i = 0; i < 9; i++) {
-        for (int j = 0; j < 9; j++) {
-            if (grid.number(i, j) == 0) {
-                row = i;
-                col = j;
-                return true;
+/*  -V: checks puzzle/solution pairs, one to a line with white space
+    between the two, reading the input in large blocks rather than a
+    line at a time. Prints a line for every pair that fails (nothing
+    for the rest) and returns 2 if any did */
+template <int B>
+int validateBatch(istream &in) {
+    auto start = chrono::steady_clock::now();
+    vector<char> buffer(1 << 20);
+    size_t have = 0;
+    unsigned long lineno = 0, pairs = 0, bad = 0;
+    string out;
+    for (;;) {
+        if (have == buffer.size())  // one line fills it
+            buffer.resize(2 * buffer.size());
+        in.read(buffer.data() + have, buffer.size() - have);
+        have += in.gcount();
+        bool eof = !in;
+        const char *p = buffer.data(), *end = p + have;
+        while (p < end) {
+            const char *eol = (const char *)memchr(p, '\n', end - p);
+            if (eol == nullptr && !eof) break;  // the rest comes with the next block
+            if (eol == nullptr) eol = end;
+            lineno++;
+            // tolerate CRLF endings, the ^Z DOS end-of-file marker and
+            // trailing blanks
+            const char *last = eol;
+            while (last > p && (last[-1] == '\r' || last[-1] == '\x1a' ||
+                                last[-1] == ' ' || last[-1] == '\t'))
+                last--;
+            while (p < last && (*p == ' ' || *p == '\t')) p++;
+            if (p < last) {
+                pairs++;
+                string fault = checkPair<B>(p, last);
+                if (!fault.empty()) {
+                    bad++;
+                    out += "line " + to_string(lineno) + ": " + fault + "\n";
+                }
             }
+            p = eol < end ? eol + 1 : end;
         }
+        if (out.size() >= 1 << 16) {
+            cout.write(out.data(), out.size());
+            out.clear();
+        }
+        have = end - p;
+        memmove(buffer.data(), p, have);
+        if (eof) break;
     }
-    return false;
+    cout.write(out.data(), out.size());
+    cout.flush();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << pairs << " pairs in " << secs << " s ("
+         << (secs > 0 ? pairs / secs : 0) << " pairs/sec), " << bad << " bad" << endl;
+    return bad ? 2 : 0;
 }
 
-/*  Recursively solves the rest of the sudoku grid through a back tracking
-    algorithm */
-bool solveSudoku(SudokuGrid &grid) {
-    int row, col;
-    if (!findUnassignedLocation(grid, row, col))
-        return true; // puzzle filled, solution found!
-    for (int num = 1; num <= 9; num++) {
-        if (!conflictingNumber(grid, row, col, num)) {
-            grid.setNumber(row, col, num); // try next number
-            if (solveSudoku(grid))
-                return true;                 // solved!
-            grid.setNumber(row, col, 0);   // not solved, clear number
+/*  Everything after option parsing, for one board size */
+template <int B>
+int run(const Options &opt) {
+    if (opt.serve != nullptr) {
+        SolverServer<B> server(opt);
+        return server.run(opt.serve);
+    }
+    if (opt.validate) {
+        ios::sync_with_stdio(false);
+        if (opt.file == nullptr)
+            return validateBatch<B>(cin);
+        ifstream in(opt.file, ios::binary);
+        if (!in) {
+            cerr << opt.file << ": " << strerror(errno) << endl;
+            exit(1);
         }
+        return validateBatch<B>(in);
     }
-    return false; // not solved, back track
-}
-
-/*  Prints out the grid */
-void printGrid(SudokuGrid &grid) {
-    int k = 0;
-    for(int i = 0; i < 9; i++) {
-            for(int j = 0; j < 9; j++) {
-            if(k == 0) std::cout << "\n";
-            else if(k % 27 == 0) std::cout << "\n------+-------+------\n";
-            else if(k % 9 == 0) std::cout << "\n";
-            else if(k % 3 == 0) std::cout << "| ";
-            if(grid.number(i,j) == 0) std::cout << ". ";
-            else std::cout << ((char)(grid.number(i, j) + '0')) << " ";
-            k++;
+    if (opt.batch) {
+        ios::sync_with_stdio(false);
+        if (opt.file == nullptr) {
+            solveBatch<B>(cin, opt);
+        } else if (MappedPuzzleFile::boxSizeOf(opt.file) != 0) {
+            MappedPuzzleFile packed;
+            string error;
+            if (!packed.open(opt.file, error)) {
+                cerr << opt.file << ": " << error << endl;
+                exit(1);
+            }
+            solvePacked<B>(packed, opt);
+        } else {
+            ifstream in(opt.file);
+            if (!in) {
+                cerr << opt.file << ": " << strerror(errno) << endl;
+                exit(1);
+            }
+            solveBatch<B>(in, opt);
         }
+        return 0;
     }
-    std::cout << "\n";
-}
 
-int main(int argc, char *argv[]) {
     std::string puzzle;
     std::cin >> puzzle;
-    if (puzzle.length() != 9 * 9 || !all_of(puzzle.begin(), puzzle.end(), [](char ch) {
-        return ch == '.' || ('1' <= ch && ch <= '9');
-    })) {
+    if (!isPuzzle<B>(puzzle)) {
         cerr << "bogus puzzle!" << endl;
         exit(1);
     }
-    SudokuGrid grid(puzzle);
+    BasicSudokuGrid<B> grid(puzzle);
 
     printGrid(grid);
-    deduce(grid);
+    if (opt.count) {
+        unique_ptr<SolverScratch<B>> scratch(new SolverScratch<B>);
+        int solutions = countPuzzle(grid, opt, *scratch);
+        if (solutions > 0)
+            printGrid(grid);
+        std::cout << "\n";
+        if (solutions == 0) std::cout << "no solution";
+        else if (solutions == 1) std::cout << "1 solution (unique)";
+        else if (solutions >= opt.limit) std::cout << "at least " << solutions << " solutions";
+        else std::cout << solutions << " solutions";
+        std::cout << "  nodes: " << scratch->stats.nodes << "\n";
+        std::cout.flush();
+        SUDOKU_STAT(printStats(scratch->stats, 1, opt.stats));
+        return solutions == 1 ? 0 : 2;
+    }
+    SearchStats stats;
+    auto start = chrono::steady_clock::now();
+    deduce(grid, stats, opt.passes);
+    SUDOKU_STAT(stats.deduceMs = msSince(start));
     printGrid(grid);
-    solveSudoku(grid);
+#ifdef SUDOKU_STATS
+    auto searchStart = chrono::steady_clock::now();
+#endif
+    LearningSearch<B> learning;
+    bool splittable = opt.engine != Engine::DLX && opt.engine != Engine::Learning;
+    if (opt.threads != 1 && !splittable)
+        cerr << "-j ignored: the " << (opt.engine == Engine::DLX ? "dlx" : "learn")
+             << " engine solves a single puzzle on one thread" << endl;
+    if (opt.threads != 1 && splittable) {
+        ThreadPool pool(opt.threads);
+        solveParallel(grid, opt.engine, opt.branching, pool, stats);
+    } else if (opt.engine == Engine::Propagate) {
+        solvePropagating(grid, stats);
+    } else if (opt.engine == Engine::Iterative) {
+        solveIterative(grid, opt.branching, stats);
+    } else if (opt.engine == Engine::Learning) {
+        learning.solve(grid, opt.branching, stats);
+    } else if (opt.engine == Engine::DLX) {
+        // the links run from ~1 KB (4x4) to ~780 KB (25x25)
+        unique_ptr<DancingLinks<B>> dlx(new DancingLinks<B>);
+        dlx->solve(grid, stats);
+    } else {
+        solveSudoku(grid, opt.branching, stats);
+    }
+    auto elapsed = chrono::steady_clock::now() - start;
+    SUDOKU_STAT(stats.searchMs = msSince(searchStart));
     printGrid(grid);
+    std::cout.flush();
+    SUDOKU_STAT(printStats(stats, 1, opt.stats));
+
+    if (opt.verbose) {
+        cerr << "nodes: " << stats.nodes
+             << "  propagations: " << stats.propagations << "  time: "
+             << chrono::duration<double, milli>(elapsed).count() << " ms"
+             << endl;
+        cerr << "eliminated:";
+        for (int p = 0; p < DEDUCE_PASSES; p++)
+            cerr << "  " << DEDUCE_PASS_NAMES[p] << " " << stats.eliminated[p];
+        cerr << endl;
+        if (opt.engine == Engine::Learning)
+            cerr << "restarts: " << learning.restarts()
+                 << "  nogood prunes: " << learning.pruned() << endl;
+    }
 
     return 0;
 }
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog << " [-e backtrack|propagate|dlx|iterative|lanes|learn] [-b first|mrv]\n"
+         << "       " << std::string(strlen(prog), ' ') << " [-s 2-5] [-D passes] [-c [-l N]] [-v]\n"
+         << "       " << prog << " -B [options] [-C N] [--cache-file F] [file]\n"
+         << "       " << prog << " -V [-s 2-5] [file]\n"
+         << "       " << prog << " --serve socket [options] [-C N] [--cache-file F]\n"
+         << "  -e, --engine backtrack  chronological backtracking (default)\n"
+         << "  -e, --engine propagate  propagate singles at every search node\n"
+         << "  -e, --engine dlx        exact cover with dancing links\n"
+         << "  -e, --engine iterative  backtracking on an explicit stack\n"
+         << "  -e, --engine lanes      with -B, singles on 16 puzzles at once in SIMD\n"
+         << "                          lanes, then backtrack for the rest\n"
+         << "  -e, --engine learn      backtracking that restarts on a Luby schedule\n"
+         << "                          with a new digit order, skipping the states\n"
+         << "                          it has already refuted\n"
+         << "  -b, --branch first  branch on the first empty cell (default)\n"
+         << "  -b, --branch mrv    branch on the cell with the fewest candidates\n"
+         << "  -s, --size B        B x B boxes: 2 (4x4), 3 (9x9, default), 4 (16x16),\n"
+         << "                      5 (25x25); digits past 9 are written A, B, ...\n"
+         << "  -D, --deduce P,...  deduction passes to run before searching, from\n"
+         << "                      locked, naked, hidden, xwing, all (default) or none\n"
+         << "  -c, --count         count solutions (up to the limit) instead of\n"
+         << "                      solving; exits 0 only for a unique solution\n"
+         << "  -l, --limit N       stop counting at N solutions (default 2)\n"
+         << "  -v, --verbose       report search nodes and time on stderr\n"
+         << "  -B, --batch         solve one puzzle per line of file (or stdin),\n"
+         << "                      printing one solved line per puzzle; file may\n"
+         << "                      also be packed (see sudokupack)\n"
+         << "  -V, --validate      check \"puzzle solution\" pairs, one per line of\n"
+         << "                      file (or stdin); prints the ones that fail and\n"
+         << "                      exits 2 if any do\n"
+         << "  -j, --threads N     worker threads (0: one per core); a single\n"
+         << "                      puzzle is split into parallel subsearches,\n"
+         << "                      except with -e dlx or learn\n"
+         << "  -S, --stats line|json  report search counters and deduce/search\n"
+         << "                      time on stderr (needs make STATS=1)\n"
+         << "  -C, --cache N       with -B or --serve, keep up to N solutions by\n"
+         << "                      canonical form and serve symmetric copies of a\n"
+         << "                      solved puzzle from them\n"
+         << "      --cache-file F  load the cache from F and save it back at the\n"
+         << "                      end (65536 entries unless -C says otherwise)\n"
+         << "      --serve socket  answer puzzles sent to a Unix socket, with -j\n"
+         << "                      threads, until killed (see sudokuclient)\n";
+    exit(1);
+}
+
+/*  Parses a comma separated list of deduce() pass names ("all" and
+    "none" too) into a pass mask */
+static bool parsePasses(const char *arg, unsigned &passes) {
+    passes = 0;
+    string list(arg);
+    size_t start = 0;
+    for (;;) {
+        size_t end = list.find(',', start);
+        string name = list.substr(start, end == string::npos ? string::npos : end - start);
+        int p = 0;
+        while (p < DEDUCE_PASSES && name != DEDUCE_PASS_NAMES[p]) p++;
+        if (p < DEDUCE_PASSES) passes |= 1u << p;
+        else if (name == "all") passes = ALL_PASSES;
+        else if (name != "none") return false;
+        if (end == string::npos) return true;
+        start = end + 1;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-e") || !strcmp(argv[i], "--engine")) {
+            if (++i >= argc) usage(argv[0]);
+            if (!strcmp(argv[i], "backtrack"))
+                opt.engine = Engine::Backtrack;
+            else if (!strcmp(argv[i], "propagate"))
+                opt.engine = Engine::Propagate;
+            else if (!strcmp(argv[i], "dlx"))
+                opt.engine = Engine::DLX;
+            else if (!strcmp(argv[i], "iterative"))
+                opt.engine = Engine::Iterative;
+            else if (!strcmp(argv[i], "lanes"))
+                opt.engine = Engine::Lanes;
+            else if (!strcmp(argv[i], "learn"))
+                opt.engine = Engine::Learning;
+            else
+                usage(argv[0]);
+        } else if (!strcmp(argv[i], "-b") || !strcmp(argv[i], "--branch")) {
+            if (++i >= argc) usage(argv[0]);
+            if (!strcmp(argv[i], "first"))
+                opt.branching = Branching::FirstEmpty;
+            else if (!strcmp(argv[i], "mrv"))
+                opt.branching = Branching::FewestCandidates;
+            else
+                usage(argv[0]);
+        } else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--size")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.boxSize = atoi(argv[i]);
+            if (opt.boxSize < 2 || opt.boxSize > 5) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-D") || !strcmp(argv[i], "--deduce")) {
+            if (++i >= argc || !parsePasses(argv[i], opt.passes)) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--count")) {
+            opt.count = true;
+        } else if (!strcmp(argv[i], "-l") || !strcmp(argv[i], "--limit")) {
+            if (++i >= argc) usage(argv[0]);
+            char *end;
+            opt.limit = (int)strtol(argv[i], &end, 10);
+            if (*end != '\0' || opt.limit < 2) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose")) {
+            opt.verbose = true;
+        } else if (!strcmp(argv[i], "-B") || !strcmp(argv[i], "--batch")) {
+            opt.batch = true;
+        } else if (!strcmp(argv[i], "-V") || !strcmp(argv[i], "--validate")) {
+            opt.validate = true;
+        } else if (!strcmp(argv[i], "-j") || !strcmp(argv[i], "--threads")) {
+            if (++i >= argc) usage(argv[0]);
+            char *end;
+            opt.threads = (int)strtol(argv[i], &end, 10);
+            if (*end != '\0' || opt.threads < 0) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-S") || !strcmp(argv[i], "--stats")) {
+            if (++i >= argc) usage(argv[0]);
+            if (!strcmp(argv[i], "line"))
+                opt.stats = StatsFormat::Line;
+            else if (!strcmp(argv[i], "json"))
+                opt.stats = StatsFormat::JSON;
+            else
+                usage(argv[0]);
+#ifndef SUDOKU_STATS
+            cerr << argv[0] << ": built without instrumentation;"
+                 << " rebuild with make STATS=1 for --stats" << endl;
+            exit(1);
+#endif
+        } else if (!strcmp(argv[i], "-C") || !strcmp(argv[i], "--cache")) {
+            if (++i >= argc) usage(argv[0]);
+            char *end;
+            long size = strtol(argv[i], &end, 10);
+            if (*end != '\0' || size < 1) usage(argv[0]);
+            opt.cacheSize = (size_t)size;
+        } else if (!strcmp(argv[i], "--cache-file")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.cacheFile = argv[i];
+        } else if (!strcmp(argv[i], "--serve")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.serve = argv[i];
+        } else if (argv[i][0] != '-' && opt.file == nullptr) {
+            opt.file = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (opt.file != nullptr && !opt.batch && !opt.validate) usage(argv[0]);
+    if (opt.validate && (opt.batch || opt.count || opt.serve != nullptr)) usage(argv[0]);
+    if (opt.serve != nullptr && (opt.batch || opt.count)) usage(argv[0]);
+    if (opt.cacheFile != nullptr && opt.cacheSize == 0)
+        opt.cacheSize = 65536;
+    // a packed file says what size its boards are
+    int packedSize = opt.file != nullptr ? MappedPuzzleFile::boxSizeOf(opt.file) : 0;
+    if (packedSize != 0)
+        opt.boxSize = packedSize;
+
+    switch (opt.boxSize) {
+    case 2: return run<2>(opt);
+    case 4: return run<4>(opt);
+    case 5: return run<5>(opt);
+    default: return run<3>(opt);
+    }
+}
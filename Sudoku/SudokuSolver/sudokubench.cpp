@@ -0,0 +1,246 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <vector>
+#include "SudokuSolver.h"
+#include "DancingLinks.h"
+#include "IterativeSearch.h"
+#include "LearningSearch.h"
+#include "Percentile.h"
+#include "PuzzleFile.h"
+
+using namespace std;
+
+/*  One engine and flag combination to time */
+struct Config {
+    const char *engine;
+    const char *branching;  // "-" where the engine picks its own cells
+    Engine e;
+    Branching b;
+};
+
+static const Config CONFIGS[] = {
+    {"backtrack", "first", Engine::Backtrack, Branching::FirstEmpty},
+    {"backtrack", "mrv", Engine::Backtrack, Branching::FewestCandidates},
+    {"propagate", "-", Engine::Propagate, Branching::FewestCandidates},
+    {"dlx", "-", Engine::DLX, Branching::FirstEmpty},
+    {"iterative", "first", Engine::Iterative, Branching::FirstEmpty},
+    {"iterative", "mrv", Engine::Iterative, Branching::FewestCandidates},
+    {"learn", "first", Engine::Learning, Branching::FirstEmpty},
+    {"learn", "mrv", Engine::Learning, Branching::FewestCandidates},
+};
+
+/*  Command line settings */
+struct Options {
+    int boxSize;
+    int runs;               // timed passes over each file
+    const char *engine;     // only this engine, or nullptr for all
+    bool perPuzzle;         // one row per puzzle instead of per file
+    vector<const char *> files;
+    Options() : boxSize(3), runs(5), engine(nullptr), perPuzzle(false) {}
+};
+
+/*  A puzzle held in memory, with its line number in the file (record
+    number for a packed file) */
+template <int B>
+struct Puzzle {
+    unsigned long line;
+    BasicSudokuGrid<B> grid;
+};
+
+/*  Reads every puzzle line of file, skipping blank lines and
+    reporting bogus ones, as solvesudoku -B does; or every record of a
+    packed file */
+template <int B>
+vector<Puzzle<B>> loadPuzzles(const char *file) {
+    typedef BasicSudokuGrid<B> Grid;
+    vector<Puzzle<B>> puzzles;
+    if (MappedPuzzleFile::boxSizeOf(file) != 0) {
+        MappedPuzzleFile packed;
+        string error;
+        if (!packed.open(file, error) || packed.boxSize() != B) {
+            cerr << file << ": " << (error.empty() ? "wrong board size for -s" : error)
+                 << endl;
+            exit(1);
+        }
+        for (uint64_t i = 0; i < packed.count(); i++) {
+            puzzles.push_back(Puzzle<B>{(unsigned long)i + 1, Grid()});
+            if (!unpackGrid(packed.record(i), puzzles.back().grid)) {
+                cerr << file << ": record " << i + 1 << ": bogus puzzle!" << endl;
+                puzzles.pop_back();
+            }
+        }
+        return puzzles;
+    }
+    ifstream in(file);
+    if (!in) {
+        cerr << file << ": " << strerror(errno) << endl;
+        exit(1);
+    }
+    string line;
+    unsigned long lineno = 0;
+    while (getline(in, line)) {
+        lineno++;
+        // tolerate CRLF endings and the ^Z DOS end-of-file marker
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\x1a'))
+            line.pop_back();
+        if (line.empty()) continue;
+        if (line.length() != (size_t)Grid::CELLS ||
+            !all_of(line.begin(), line.end(), Grid::isDigitChar)) {
+            cerr << file << ": line " << lineno << ": bogus puzzle!" << endl;
+            continue;
+        }
+        puzzles.push_back(Puzzle<B>{lineno, Grid(line)});
+    }
+    return puzzles;
+}
+
+/*  Deduces and searches exactly as solvesudoku does for one puzzle */
+template <int B>
+void solveOne(BasicSudokuGrid<B> &grid, const Config &config,
+              DancingLinks<B> &dlx, LearningSearch<B> &learning, SearchStats &stats) {
+    deduce(grid, stats, ALL_PASSES);
+    if (config.e == Engine::Propagate)
+        solvePropagating(grid, stats);
+    else if (config.e == Engine::DLX)
+        dlx.solve(grid, stats);
+    else if (config.e == Engine::Iterative)
+        solveIterative(grid, config.b, stats);
+    else if (config.e == Engine::Learning)
+        learning.solve(grid, config.b, stats);
+    else
+        solveSudoku(grid, config.b, stats);
+}
+
+/*  Writes one CSV row: latency summary of samples (in microseconds),
+    throughput, and the search counters of a single pass */
+static void report(const char *file, const string &puzzle, const Config &config,
+                   size_t puzzles, int runs, vector<double> &samples,
+                   const SearchStats &stats) {
+    sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double us : samples) total += us;
+    cout << file << ',' << puzzle << ',' << config.engine << ','
+         << config.branching << ',' << puzzles << ',' << runs << ','
+         << samples.front() << ',' << percentile(samples, 50) << ','
+         << percentile(samples, 99) << ','
+         << (total > 0 ? samples.size() / (total / 1e6) : 0) << ','
+         << stats.nodes << ',' << stats.propagations << '\n';
+}
+
+/*  Times every puzzle of file under config: one untimed pass to warm
+    up and gather the search counters (they are the same every pass),
+    then opt.runs timed passes */
+template <int B>
+void benchFile(const char *file, const vector<Puzzle<B>> &puzzles,
+               const Config &config, const Options &opt, DancingLinks<B> &dlx,
+               LearningSearch<B> &learning) {
+    typedef chrono::steady_clock Clock;
+    vector<SearchStats> stats(puzzles.size());
+    for (size_t p = 0; p < puzzles.size(); p++) {
+        BasicSudokuGrid<B> grid = puzzles[p].grid;
+        solveOne(grid, config, dlx, learning, stats[p]);
+    }
+
+    vector<vector<double>> samples(puzzles.size());
+    for (int r = 0; r < opt.runs; r++) {
+        for (size_t p = 0; p < puzzles.size(); p++) {
+            BasicSudokuGrid<B> grid = puzzles[p].grid;
+            SearchStats ignored;
+            auto start = Clock::now();
+            solveOne(grid, config, dlx, learning, ignored);
+            auto elapsed = Clock::now() - start;
+            samples[p].push_back(chrono::duration<double, micro>(elapsed).count());
+        }
+    }
+
+    if (opt.perPuzzle) {
+        for (size_t p = 0; p < puzzles.size(); p++)
+            report(file, to_string(puzzles[p].line), config, 1, opt.runs,
+                   samples[p], stats[p]);
+        return;
+    }
+    vector<double> all;
+    SearchStats total;
+    for (size_t p = 0; p < puzzles.size(); p++) {
+        all.insert(all.end(), samples[p].begin(), samples[p].end());
+        total.add(stats[p]);
+    }
+    if (!all.empty())
+        report(file, "all", config, puzzles.size(), opt.runs, all, total);
+}
+
+template <int B>
+int run(const Options &opt) {
+    unique_ptr<DancingLinks<B>> dlx(new DancingLinks<B>);
+    LearningSearch<B> learning;
+    cout << fixed << setprecision(2);
+    cout << "file,puzzle,engine,branching,puzzles,runs,min_us,median_us,"
+            "p99_us,puzzles_per_sec,nodes,propagations\n";
+    for (const char *file : opt.files) {
+        vector<Puzzle<B>> puzzles = loadPuzzles<B>(file);
+        for (const Config &config : CONFIGS) {
+            if (opt.engine != nullptr && strcmp(opt.engine, config.engine))
+                continue;
+            benchFile(file, puzzles, config, opt, *dlx, learning);
+            cout.flush();
+        }
+    }
+    return 0;
+}
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog << " [-n runs] [-e backtrack|propagate|dlx|iterative|learn]"
+         << " [-s 2-5] [-p] file...\n"
+         << "  -n, --runs N        timed passes over each file (default 5)\n"
+         << "  -e, --engine E      time only this engine (default: all of them,\n"
+         << "                      backtrack, iterative and learn with first and mrv)\n"
+         << "  -s, --size B        B x B boxes, as for solvesudoku (default 3)\n"
+         << "  -p, --per-puzzle    one CSV row per puzzle instead of per file\n"
+         << "Writes CSV to stdout; latencies are in microseconds per puzzle.\n";
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") || !strcmp(argv[i], "--runs")) {
+            if (++i >= argc) usage(argv[0]);
+            char *end;
+            opt.runs = (int)strtol(argv[i], &end, 10);
+            if (*end != '\0' || opt.runs < 1) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-e") || !strcmp(argv[i], "--engine")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.engine = argv[i];
+            if (strcmp(opt.engine, "backtrack") && strcmp(opt.engine, "propagate") &&
+                strcmp(opt.engine, "dlx") && strcmp(opt.engine, "iterative") &&
+                strcmp(opt.engine, "learn"))
+                usage(argv[0]);
+        } else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--size")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.boxSize = atoi(argv[i]);
+            if (opt.boxSize < 2 || opt.boxSize > 5) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-p") || !strcmp(argv[i], "--per-puzzle")) {
+            opt.perPuzzle = true;
+        } else if (argv[i][0] != '-') {
+            opt.files.push_back(argv[i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (opt.files.empty()) usage(argv[0]);
+
+    switch (opt.boxSize) {
+    case 2: return run<2>(opt);
+    case 4: return run<4>(opt);
+    case 5: return run<5>(opt);
+    default: return run<3>(opt);
+    }
+}
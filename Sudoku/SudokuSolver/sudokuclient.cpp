@@ -0,0 +1,212 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Percentile.h"
+#include "SolverSocket.h"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+/*  Command line settings */
+struct Options {
+    int depth;    // requests in flight at once
+    int repeat;   // times through the input
+    bool quiet;   // no solutions on stdout
+    const char *socket;
+    const char *file;  // input, stdin if nullptr
+    Options() : depth(1), repeat(1), quiet(false), socket(nullptr), file(nullptr) {}
+};
+
+/*  A puzzle line of the input */
+struct Puzzle {
+    string text;
+    unsigned long lineno;
+};
+
+/*  Requests sent but not yet answered, shared by the sending thread and
+    the receiving one */
+class Window {
+public:
+    Window(int depth, size_t total) : depth_(depth), inFlight_(0), sent_(total) {}
+
+    /*  Waits for room, then books up to want requests starting at first,
+        stamped with the time they go out; returns how many */
+    size_t open(size_t first, size_t want) {
+        unique_lock<mutex> guard(lock_);
+        room_.wait(guard, [this]() { return inFlight_ < depth_; });
+        size_t n = min(want, (size_t)(depth_ - inFlight_));
+        auto now = Clock::now();
+        for (size_t i = 0; i < n; i++)
+            sent_[first + i] = now;
+        inFlight_ += (int)n;
+        return n;
+    }
+
+    /*  Marks request seq answered; returns when it was sent */
+    Clock::time_point close(size_t seq) {
+        lock_guard<mutex> guard(lock_);
+        inFlight_--;
+        room_.notify_one();
+        return sent_[seq];
+    }
+
+private:
+    mutex lock_;
+    condition_variable room_;
+    int depth_, inFlight_;
+    vector<Clock::time_point> sent_;
+};
+
+/*  Sends every puzzle opt.repeat times, as many requests to a write as
+    the window has room for, then closes the sending side */
+static void sendAll(int fd, const vector<Puzzle> &puzzles, const Options &opt,
+                    Window &window) {
+    size_t total = puzzles.size() * opt.repeat;
+    string frames;
+    for (size_t seq = 0; seq < total; ) {
+        size_t n = window.open(seq, total - seq);
+        frames.clear();
+        for (size_t i = 0; i < n; i++)
+            appendFrame(frames, puzzles[(seq + i) % puzzles.size()].text);
+        if (!writeAll(fd, frames))
+            break;
+        seq += n;
+    }
+    shutdown(fd, SHUT_WR);
+}
+
+/*  Solves every puzzle of in on the server and prints the replies as
+    solvesudoku -B would, then the throughput and latency on stderr */
+static int solveAll(istream &in, const Options &opt) {
+    vector<Puzzle> puzzles;
+    string line;
+    unsigned long lineno = 0;
+    while (getline(in, line)) {
+        lineno++;
+        // tolerate CRLF endings and the ^Z DOS end-of-file marker
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\x1a'))
+            line.pop_back();
+        if (!line.empty())
+            puzzles.push_back({line, lineno});
+    }
+    if (puzzles.empty())
+        return 0;
+
+    string error;
+    int fd = connectUnix(opt.socket, error);
+    if (fd < 0) {
+        cerr << opt.socket << ": " << error << endl;
+        return 1;
+    }
+    size_t total = puzzles.size() * opt.repeat;
+    Window window(opt.depth, total);
+    vector<double> latency;  // microseconds
+    latency.reserve(total);
+    auto start = Clock::now();
+    thread sender(sendAll, fd, cref(puzzles), cref(opt), ref(window));
+
+    FrameReader replies(fd);
+    string reply, out;
+    int status = 0;
+    size_t seq;
+    for (seq = 0; seq < total; seq++) {
+        if (replies.next(reply) != FrameReader::Result::Frame || reply.empty()) {
+            cerr << opt.socket << ": connection lost after " << seq << " replies" << endl;
+            status = 1;
+            break;
+        }
+        latency.push_back(chrono::duration<double, micro>(
+            Clock::now() - window.close(seq)).count());
+        const Puzzle &puzzle = puzzles[seq % puzzles.size()];
+        if (reply[0] == SolverProtocol::ERROR) {
+            cerr << "line " << puzzle.lineno << ": " << reply.substr(1) << endl;
+            continue;
+        }
+        if (opt.quiet) continue;
+        // unsolvable puzzles come back unchanged, as from -B
+        if (reply[0] == SolverProtocol::SOLVED)
+            out.append(reply, 1, string::npos);
+        else
+            out += puzzle.text;
+        out.push_back('\n');
+        if (out.size() >= 1 << 16) {
+            cout.write(out.data(), out.size());
+            out.clear();
+        }
+    }
+    double secs = chrono::duration<double>(Clock::now() - start).count();
+    cout.write(out.data(), out.size());
+    cout.flush();
+    // a sender still blocked on a dead connection gets an error now
+    shutdown(fd, SHUT_RDWR);
+    for (size_t i = seq; i < total; i++)
+        window.close(i);
+    sender.join();
+    close(fd);
+
+    sort(latency.begin(), latency.end());
+    cerr << seq << " puzzles in " << secs << " s ("
+         << (secs > 0 ? seq / secs : 0) << " puzzles/sec, depth " << opt.depth
+         << "), latency min " << percentile(latency, 0) << " us, median "
+         << percentile(latency, 50) << " us, p99 " << percentile(latency, 99)
+         << " us" << endl;
+    return status;
+}
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog << " [-p depth] [-r repeat] [-q] socket [file]\n"
+         << "  sends each puzzle line of file (or stdin) to solvesudoku --serve\n"
+         << "  on socket and prints the replies as solvesudoku -B would\n"
+         << "  -p, --pipeline N  keep up to N requests in flight (default 1)\n"
+         << "  -r, --repeat N    send the input N times over\n"
+         << "  -q, --quiet       print only the throughput and latency summary\n";
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-p") || !strcmp(argv[i], "--pipeline")) {
+            if (++i >= argc) usage(argv[0]);
+            char *end;
+            opt.depth = (int)strtol(argv[i], &end, 10);
+            if (*end != '\0' || opt.depth < 1) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--repeat")) {
+            if (++i >= argc) usage(argv[0]);
+            char *end;
+            opt.repeat = (int)strtol(argv[i], &end, 10);
+            if (*end != '\0' || opt.repeat < 1) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-q") || !strcmp(argv[i], "--quiet")) {
+            opt.quiet = true;
+        } else if (argv[i][0] != '-' && opt.socket == nullptr) {
+            opt.socket = argv[i];
+        } else if (argv[i][0] != '-' && opt.file == nullptr) {
+            opt.file = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (opt.socket == nullptr) usage(argv[0]);
+
+    ios::sync_with_stdio(false);
+    if (opt.file == nullptr)
+        return solveAll(cin, opt);
+    ifstream in(opt.file);
+    if (!in) {
+        cerr << opt.file << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    return solveAll(in, opt);
+}
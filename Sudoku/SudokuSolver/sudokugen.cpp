@@ -0,0 +1,255 @@
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "SudokuSolver.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/*  Which puzzles are kept */
+enum class Difficulty {
+    Any,
+    Easy,  // naked and hidden singles alone solve it
+    Hard   // needs at least one guess
+};
+
+/*  Command line settings */
+struct Options {
+    int boxSize;
+    unsigned long count;  // puzzles to write, 0 for no end
+    int threads;
+    int minClues;         // stop removing clues at this many
+    Difficulty difficulty;
+    unsigned long seed;
+    Options() : boxSize(3), count(1), threads(1), minClues(0),
+                difficulty(Difficulty::Any), seed(random_device()()) {}
+};
+
+/*  A random full grid. The diagonal boxes share no row or column, so
+    they can take any shuffle of the digits; the solver fills in the
+    rest (retrying on the rare dead end) */
+template <int B>
+BasicSudokuGrid<B> randomSolution(mt19937 &rng, SearchStats &stats) {
+    typedef BasicSudokuGrid<B> Grid;
+    const int N = Grid::N;
+    int digits[N];
+    for (;;) {
+        Grid grid;
+        for (int b = 0; b < N; b += B + 1) {
+            iota(digits, digits + N, 1);
+            shuffle(digits, digits + N, rng);
+            for (int i = 0; i < N; i++) {
+                int k = Grid::tables.unitCells[2 * N + b][i];
+                grid.setNumber(Grid::tables.cellRow[k], Grid::tables.cellCol[k],
+                               digits[i]);
+            }
+        }
+        autoPencil(grid);
+        if (solvePropagating(grid, stats))
+            return grid;
+    }
+}
+
+/*  Whether taking v out of cell k loses uniqueness. The puzzle (with k
+    already emptied) is known to have the solution with v at k, so it
+    is unique exactly when striking v from k's pencils leaves no
+    solution at all: one satisfiability search instead of counting
+    to two */
+template <int B>
+bool hasOtherSolution(const BasicSudokuGrid<B> &puzzle, int k, int v,
+                      SearchStats &stats) {
+    typedef BasicSudokuGrid<B> Grid;
+    if (puzzle.candidates(k) == Grid::digitBit(v))
+        return false; // the other clues still pin it down
+    Grid grid = puzzle;
+    autoPencil(grid);
+    grid.clearPencil(Grid::tables.cellRow[k], Grid::tables.cellCol[k], v);
+    return solvePropagating(grid, stats);
+}
+
+/*  A random full grid with clues taken out in random order for as long
+    as the solution stays unique (or until opt.minClues are left) */
+template <int B>
+BasicSudokuGrid<B> makePuzzle(mt19937 &rng, const Options &opt,
+                              SearchStats &stats) {
+    typedef BasicSudokuGrid<B> Grid;
+    Grid puzzle = randomSolution<B>(rng, stats);
+    int order[Grid::CELLS];
+    iota(order, order + Grid::CELLS, 0);
+    shuffle(order, order + Grid::CELLS, rng);
+    int clues = Grid::CELLS;
+    for (int k : order) {
+        if (clues <= opt.minClues) break;
+        int row = Grid::tables.cellRow[k], col = Grid::tables.cellCol[k];
+        int v = puzzle.number(k);
+        puzzle.setNumber(row, col, 0);
+        if (hasOtherSolution(puzzle, k, v, stats))
+            puzzle.setNumber(row, col, v); // needed, put it back
+        else
+            clues--;
+    }
+    return puzzle;
+}
+
+/*  True if the puzzle is as hard as asked for */
+template <int B>
+bool wanted(const BasicSudokuGrid<B> &puzzle, Difficulty difficulty) {
+    if (difficulty == Difficulty::Any)
+        return true;
+    BasicSudokuGrid<B> grid = puzzle;
+    SearchStats stats;
+    autoPencil(grid);
+    solvePropagating(grid, stats);
+    bool singles = stats.nodes == 1; // solved without a guess
+    return singles == (difficulty == Difficulty::Easy);
+}
+
+/*  Appends count puzzles to out, one line each. Chunk seq draws from
+    its own generator seeded with (seed, seq), so the output depends on
+    the seed alone and not on which thread ran which chunk */
+template <int B>
+void generateChunk(unsigned long seq, unsigned long count, const Options &opt,
+                   string &out, SearchStats &stats) {
+    seed_seq seeds{(unsigned)opt.seed, (unsigned)(opt.seed >> 16 >> 16),
+                   (unsigned)seq};
+    mt19937 rng(seeds);
+    for (unsigned long made = 0; made < count; ) {
+        BasicSudokuGrid<B> puzzle = makePuzzle<B>(rng, opt, stats);
+        if (!wanted(puzzle, opt.difficulty))
+            continue;
+        formatGrid(puzzle, out);
+        made++;
+    }
+}
+
+/*  Streams opt.count puzzles to stdout. With more than one thread,
+    chunks are generated on a work-stealing pool and written in order
+    through a reorder buffer, as solvesudoku's batch mode does */
+template <int B>
+int run(const Options &opt) {
+    const unsigned long CHUNK = 16;  // puzzles per task
+    ios::sync_with_stdio(false);
+    ReorderBuffer results;
+    unique_ptr<ThreadPool> pool;
+    if (opt.threads != 1)
+        pool.reset(new ThreadPool(opt.threads));
+    int workers = pool ? pool->size() : 1;
+    vector<SearchStats> stats(workers);
+
+    unsigned long puzzles = 0, submitted = 0, written = 0;
+    string out;
+    auto start = chrono::steady_clock::now();
+    while (opt.count == 0 || puzzles < opt.count) {
+        unsigned long n = opt.count == 0 ? CHUNK : min(CHUNK, opt.count - puzzles);
+        unsigned long seq = submitted++;
+        puzzles += n;
+        if (!pool) {
+            out.clear();
+            generateChunk<B>(seq, n, opt, out, stats[0]);
+            cout.write(out.data(), out.size());
+            cout.flush();
+            written++;
+            continue;
+        }
+        pool->submit([&, seq, n]() {
+            string made;
+            generateChunk<B>(seq, n, opt, made, stats[ThreadPool::currentWorker()]);
+            results.put(seq, std::move(made));
+        });
+        // write whatever is ready; block once too many chunks are in flight
+        while (written < submitted &&
+               results.take(out, submitted - written > 4 * (unsigned long)workers)) {
+            cout.write(out.data(), out.size());
+            cout.flush();
+            written++;
+        }
+    }
+    while (written < submitted && results.take(out, true)) {
+        cout.write(out.data(), out.size());
+        written++;
+    }
+    cout.flush();
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    unsigned long nodes = 0;
+    for (const SearchStats &s : stats)
+        nodes += s.nodes;
+    cerr << puzzles << " puzzles in " << secs << " s ("
+         << (secs > 0 ? puzzles / secs : 0) << " puzzles/sec";
+    if (pool) cerr << ", " << workers << " threads";
+    cerr << "), " << nodes << " search nodes, seed " << opt.seed << endl;
+    return 0;
+}
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog << " [-n count] [-j threads] [-s 2-4] [-d any|easy|hard]\n"
+         << "       " << std::string(strlen(prog), ' ') << " [-m clues] [-r seed]\n"
+         << "  -n, --count N       puzzles to write, one per line (default 1;\n"
+         << "                      0: keep going)\n"
+         << "  -j, --threads N     worker threads (0: one per core)\n"
+         << "  -s, --size B        B x B boxes: 2 (4x4), 3 (9x9, default) or 4 (16x16,\n"
+         << "                      seconds per puzzle)\n"
+         << "  -d, --difficulty any   keep every puzzle (default)\n"
+         << "  -d, --difficulty easy  keep puzzles solved by singles alone\n"
+         << "  -d, --difficulty hard  keep puzzles that need a guess\n"
+         << "  -m, --min-clues N   stop taking clues out at N (default 0: take out\n"
+         << "                      every clue that can go)\n"
+         << "  -r, --seed N        random seed; the same seed gives the same puzzles\n";
+    exit(1);
+}
+
+/*  Parses a non-negative number or bails out with usage */
+static unsigned long number(const char *prog, const char *arg) {
+    char *end;
+    unsigned long n = strtoul(arg, &end, 10);
+    if (*arg == '-' || *arg == '\0' || *end != '\0') usage(prog);
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") || !strcmp(argv[i], "--count")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.count = number(argv[0], argv[i]);
+        } else if (!strcmp(argv[i], "-j") || !strcmp(argv[i], "--threads")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.threads = (int)number(argv[0], argv[i]);
+        } else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--size")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.boxSize = (int)number(argv[0], argv[i]);
+            if (opt.boxSize < 2 || opt.boxSize > 4) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-d") || !strcmp(argv[i], "--difficulty")) {
+            if (++i >= argc) usage(argv[0]);
+            if (!strcmp(argv[i], "any"))
+                opt.difficulty = Difficulty::Any;
+            else if (!strcmp(argv[i], "easy"))
+                opt.difficulty = Difficulty::Easy;
+            else if (!strcmp(argv[i], "hard"))
+                opt.difficulty = Difficulty::Hard;
+            else
+                usage(argv[0]);
+        } else if (!strcmp(argv[i], "-m") || !strcmp(argv[i], "--min-clues")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.minClues = (int)number(argv[0], argv[i]);
+        } else if (!strcmp(argv[i], "-r") || !strcmp(argv[i], "--seed")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.seed = number(argv[0], argv[i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    switch (opt.boxSize) {
+    case 2: return run<2>(opt);
+    case 4: return run<4>(opt);
+    default: return run<3>(opt);
+    }
+}
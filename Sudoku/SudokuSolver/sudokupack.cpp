@@ -0,0 +1,144 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include "PuzzleFile.h"
+
+using namespace std;
+
+/*  Command line settings */
+struct Options {
+    int boxSize;
+    bool unpack;
+    const char *output;  // packed file to write
+    const char *file;    // input, stdin if nullptr
+    Options() : boxSize(3), unpack(false), output(nullptr), file(nullptr) {}
+};
+
+/*  Packs every puzzle line of in into a new packed file, skipping
+    blank lines and reporting bogus ones, as solvesudoku -B does */
+template <int B>
+int pack(istream &in, const Options &opt) {
+    typedef BasicSudokuGrid<B> Grid;
+    PuzzleFileWriter out;
+    string error;
+    if (!out.open(opt.output, B, error)) {
+        cerr << opt.output << ": " << error << endl;
+        return 1;
+    }
+    vector<uint8_t> record(PuzzleFileFormat::recordBytes(B));
+    string line;
+    unsigned long lineno = 0;
+    while (getline(in, line)) {
+        lineno++;
+        // tolerate CRLF endings and the ^Z DOS end-of-file marker
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\x1a'))
+            line.pop_back();
+        if (line.empty()) continue;
+        if (line.length() != (size_t)Grid::CELLS ||
+            !all_of(line.begin(), line.end(), Grid::isDigitChar)) {
+            cerr << "line " << lineno << ": bogus puzzle!" << endl;
+            continue;
+        }
+        packGrid(Grid(line), record.data());
+        if (!out.write(record.data())) {
+            cerr << opt.output << ": " << strerror(errno) << endl;
+            return 1;
+        }
+    }
+    unsigned long count = out.count();
+    if (!out.close(error)) {
+        cerr << opt.output << ": " << error << endl;
+        return 1;
+    }
+    cerr << count << " puzzles packed" << endl;
+    return 0;
+}
+
+/*  Writes every record of a packed file as a text line */
+template <int B>
+int unpack(const MappedPuzzleFile &file) {
+    string out;
+    for (uint64_t i = 0; i < file.count(); i++) {
+        BasicSudokuGrid<B> grid;
+        if (!unpackGrid(file.record(i), grid)) {
+            cerr << "record " << i + 1 << ": bogus puzzle!" << endl;
+            continue;
+        }
+        formatGrid(grid, out);
+        if (out.size() >= 1 << 16) {
+            cout.write(out.data(), out.size());
+            out.clear();
+        }
+    }
+    cout.write(out.data(), out.size());
+    cout.flush();
+    return cout ? 0 : 1;
+}
+
+void usage(const char *prog) {
+    cerr << "usage: " << prog << " [-s 2-5] -o packed [file]\n"
+         << "       " << prog << " -u packed\n"
+         << "  -o, --output F      pack the puzzle lines of file (or stdin) into F\n"
+         << "  -s, --size B        B x B boxes, as for solvesudoku (default 3)\n"
+         << "  -u, --unpack        write the grids of a packed file as text lines\n";
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") || !strcmp(argv[i], "--output")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.output = argv[i];
+        } else if (!strcmp(argv[i], "-s") || !strcmp(argv[i], "--size")) {
+            if (++i >= argc) usage(argv[0]);
+            opt.boxSize = atoi(argv[i]);
+            if (opt.boxSize < 2 || opt.boxSize > 5) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-u") || !strcmp(argv[i], "--unpack")) {
+            opt.unpack = true;
+        } else if (argv[i][0] != '-' && opt.file == nullptr) {
+            opt.file = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    ios::sync_with_stdio(false);
+    if (opt.unpack) {
+        if (opt.file == nullptr || opt.output != nullptr) usage(argv[0]);
+        MappedPuzzleFile file;
+        string error;
+        if (!file.open(opt.file, error)) {
+            cerr << opt.file << ": " << error << endl;
+            return 1;
+        }
+        switch (file.boxSize()) {
+        case 2: return unpack<2>(file);
+        case 4: return unpack<4>(file);
+        case 5: return unpack<5>(file);
+        default: return unpack<3>(file);
+        }
+    }
+
+    if (opt.output == nullptr) usage(argv[0]);
+    ifstream in;
+    if (opt.file != nullptr) {
+        in.open(opt.file);
+        if (!in) {
+            cerr << opt.file << ": " << strerror(errno) << endl;
+            return 1;
+        }
+    }
+    istream &src = opt.file != nullptr ? in : cin;
+    switch (opt.boxSize) {
+    case 2: return pack<2>(src, opt);
+    case 4: return pack<4>(src, opt);
+    case 5: return pack<5>(src, opt);
+    default: return pack<3>(src, opt);
+    }
+}
@@ -0,0 +1,62 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use Test::More tests => 14;
+
+my $SOLVER="./solvesudoku";
+my $PUZZLES="testpuzzles.txt";
+my $dir = tempdir(CLEANUP => 1);
+
+ok(-e "$SOLVER", "$SOLVER exists");
+
+open(my $fh, $PUZZLES) or die "$!\n";
+my @puzzles = grep { /^[\.1-9]{81}$/ } map { s/\s+$//r } <$fh>;
+close $fh;
+
+# 81 digit solution that keeps the givens and has every digit
+# once in each row, column and block
+sub solves {
+    my ($puzzle, $solution) = @_;
+    return 0 unless $solution =~ /^[1-9]{81}$/;
+    for my $k (0 .. 80) {
+        my $p = substr($puzzle, $k, 1);
+        return 0 if $p ne '.' and $p ne substr($solution, $k, 1);
+    }
+    for my $u (0 .. 8) {
+        my (%row, %col, %box);
+        for my $v (0 .. 8) {
+            $row{substr($solution, 9 * $u + $v, 1)} = 1;
+            $col{substr($solution, 9 * $v + $u, 1)} = 1;
+            my $r = 3 * int($u / 3) + int($v / 3);
+            my $c = 3 * ($u % 3) + $v % 3;
+            $box{substr($solution, 9 * $r + $c, 1)} = 1;
+        }
+        return 0 unless keys %row == 9 and keys %col == 9 and keys %box == 9;
+    }
+    return 1;
+}
+
+foreach my $engine ("backtrack", "propagate", "dlx") {
+    my @solutions = split /\n/, `$SOLVER -B -e $engine $PUZZLES 2>/dev/null`;
+    is(scalar @solutions, scalar @puzzles, "$engine: one line per puzzle");
+    my $bad = grep { !solves($puzzles[$_], $solutions[$_] // "") } 0 .. $#puzzles;
+    is($bad, 0, "$engine: every puzzle solved");
+}
+
+my $serial = `$SOLVER -B -e dlx $PUZZLES 2>/dev/null`;
+my $parallel = `$SOLVER -B -e dlx -j 4 $PUZZLES 2>/dev/null`;
+is($parallel, $serial, "-j 4 keeps input order");
+
+# givens that clash, on an almost empty grid and on a full one: echoed
+# as unsolved straight away, by every engine
+my $pair = "11" . "." x 79;
+my $full = "994582136268931745315476982689715324432869571157243869821657493943128657576394218";
+`printf '$pair\\n$full\\n' > $dir/clash.txt`;
+foreach my $engine ("backtrack", "propagate", "dlx", "iterative", "lanes", "learn") {
+    my $out = `timeout 20 $SOLVER -B -e $engine $dir/clash.txt 2>$dir/err.txt`;
+    ok(($out eq "$pair\n$full\n" and `cat $dir/err.txt` =~ /2 unsolved/),
+       "$engine: clashing givens are unsolved");
+}
@@ -0,0 +1,65 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use Test::More tests => 13;
+
+my $SOLVER="./solvesudoku";
+my @DIGITS = (1 .. 9, 'A' .. 'P');
+
+ok(-e "$SOLVER", "$SOLVER exists");
+
+# N*N character solution for B x B boxes that keeps the givens and has
+# every digit once in each row, column and box
+sub solves {
+    my ($B, $puzzle, $solution) = @_;
+    my $N = $B * $B;
+    my $digits = join '', @DIGITS[0 .. $N - 1];
+    return 0 unless $solution =~ /^[$digits]{@{[$N * $N]}}$/;
+    for my $k (0 .. $N * $N - 1) {
+        my $p = substr($puzzle, $k, 1);
+        return 0 if $p ne '.' and $p ne substr($solution, $k, 1);
+    }
+    for my $u (0 .. $N - 1) {
+        my (%row, %col, %box);
+        for my $v (0 .. $N - 1) {
+            $row{substr($solution, $N * $u + $v, 1)} = 1;
+            $col{substr($solution, $N * $v + $u, 1)} = 1;
+            my $r = $B * int($u / $B) + int($v / $B);
+            my $c = $B * ($u % $B) + $v % $B;
+            $box{substr($solution, $N * $r + $c, 1)} = 1;
+        }
+        return 0 unless keys %row == $N and keys %col == $N and keys %box == $N;
+    }
+    return 1;
+}
+
+# plain backtracking is hopeless on the larger boards
+my %engines = (
+    2 => ["backtrack", "propagate", "dlx"],
+    4 => ["backtrack -b mrv", "propagate", "dlx"],
+    5 => ["propagate", "dlx"],
+);
+
+foreach my $B (2, 4, 5) {
+    my $N = $B * $B;
+    my $file = "testpuzzles${N}x${N}.txt";
+    open(my $fh, $file) or die "$file: $!\n";
+    my @puzzles = map { s/\s+$//r } <$fh>;
+    close $fh;
+    foreach my $engine (@{$engines{$B}}) {
+        my @solutions = split /\n/, `$SOLVER -B -s $B -e $engine $file 2>/dev/null`;
+        my $bad = grep { !solves($B, $puzzles[$_], $solutions[$_] // "") } 0 .. $#puzzles;
+        is($bad, 0, "${N}x${N} $engine: every puzzle solved");
+    }
+}
+
+my @grid = split /\n/, `head -1 testpuzzles4x4.txt | $SOLVER -s 2`;
+is($grid[3], "----+----", "4x4 grid is ruled into 2x2 boxes");
+is(scalar(grep { /^[.1-4] [.1-4] \| [.1-4] [.1-4] $/ } @grid),
+   12, "4x4 grid prints three 4 line boards");
+
+my $bogus = `echo 12 | $SOLVER -s 2 2>&1`;
+like($bogus, qr/bogus puzzle/, "wrong length for the size is rejected");
+is(system("$SOLVER -s 6 </dev/null >/dev/null 2>&1") >> 8, 1, "-s 6 is refused");
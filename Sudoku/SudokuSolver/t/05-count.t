@@ -0,0 +1,46 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use Test::More tests => 12;
+
+my $SOLVER="./solvesudoku";
+my $PUZZLES="testpuzzles.txt";
+
+ok(-e "$SOLVER", "$SOLVER exists");
+
+open(my $fh, $PUZZLES) or die "$!\n";
+my @puzzles = grep { /^[\.1-9]{81}$/ } map { s/\s+$//r } <$fh>;
+close $fh;
+
+# every test puzzle is proper; -b mrv keeps backtracking quick
+foreach my $engine ("backtrack -b mrv", "propagate", "dlx") {
+    my @counts = split /\n/, `$SOLVER -B -c -e $engine $PUZZLES 2>/dev/null`;
+    my $unique = grep { /^1 \d+$/ } @counts;
+    is($unique, scalar @puzzles, "$engine: every test puzzle unique");
+}
+
+# the empty 4x4 board has 288 solutions
+my $empty = "." x 16;
+foreach my $engine ("backtrack", "propagate", "dlx") {
+    my $out = `echo '$empty' | $SOLVER -s 2 -c -l 1000 -e $engine`;
+    like($out, qr/^288 solutions  nodes: \d+$/m, "$engine: 288 4x4 grids");
+}
+
+# blanking givens of a proper puzzle leaves it with more than one
+my $loose = $puzzles[0];
+$loose =~ s/[1-9]/./ for 1 .. 8;
+my $out = `echo '$loose' | $SOLVER -c -e dlx`;
+like($out, qr/^at least 2 solutions/m, "missing givens: at least 2 solutions");
+isnt($? >> 8, 0, "missing givens: nonzero exit");
+
+# two of the same digit in a row is no puzzle at all
+my $clash = "11" . substr($puzzles[0] =~ s/1/./gr, 2);
+$out = `echo '$clash' | $SOLVER -c -e dlx`;
+like($out, qr/^no solution/m, "clashing givens: no solution");
+
+`echo '$puzzles[0]' | $SOLVER -c -e propagate`;
+is($? >> 8, 0, "unique puzzle: zero exit");
+
+is(system("$SOLVER -c -l 1 </dev/null >/dev/null 2>&1") >> 8, 1, "-l 1 is refused");
@@ -0,0 +1,35 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use Test::More tests => 9;
+
+my $SOLVER="./solvesudoku";
+my $GENERATOR="./sudokugen";
+
+`make $GENERATOR >/dev/null 2>&1`;
+ok((!$? and -e "$GENERATOR"), "$GENERATOR built");
+
+my @puzzles = split /\n/, `$GENERATOR -n 50 -r 1 2>/dev/null`;
+is(scalar @puzzles, 50, "-n 50 writes 50 puzzles");
+is(scalar(grep { /^[\.1-9]{81}$/ } @puzzles), 50, "81 character lines");
+
+my $counts = `$GENERATOR -n 50 -r 1 2>/dev/null | $SOLVER -B -c -e propagate 2>/dev/null`;
+is(scalar(grep { /^1 / } split /\n/, $counts), 50, "every puzzle is unique");
+
+my $parallel = `$GENERATOR -n 50 -r 1 -j 3 2>/dev/null`;
+is($parallel, join("", map { "$_\n" } @puzzles), "same seed, same puzzles with -j 3");
+
+my @loose = split /\n/, `$GENERATOR -n 20 -m 40 -r 2 2>/dev/null`;
+is(scalar(grep { tr/1-9// >= 40 } @loose), 20, "-m 40 keeps at least 40 clues");
+
+# easy puzzles fall to singles: one search node each
+`$GENERATOR -n 20 -d easy -r 3 2>/dev/null | $SOLVER -B -e propagate -v 2>&1 >/dev/null`
+    =~ /, (\d+) nodes/;
+is($1, 20, "-d easy puzzles need no guessing");
+
+my $small = `$GENERATOR -s 2 -n 10 -r 4 2>/dev/null | $SOLVER -B -c -s 2 -e dlx 2>/dev/null`;
+is(scalar(grep { /^1 / } split /\n/, $small), 10, "4x4 puzzles are unique");
+
+is(system("$GENERATOR -s 5 >/dev/null 2>&1") >> 8, 1, "-s 5 is refused");
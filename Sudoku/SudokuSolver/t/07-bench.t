@@ -0,0 +1,31 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use Test::More tests => 7;
+
+my $SOLVER="./solvesudoku";
+my $BENCH="./sudokubench";
+my $PUZZLES="testpuzzles.txt";
+
+`make $BENCH >/dev/null 2>&1`;
+ok((!$? and -e "$BENCH"), "$BENCH built");
+
+my @rows = split /\n/, `$BENCH -n 1 $PUZZLES 2>/dev/null`;
+is(shift @rows, "file,puzzle,engine,branching,puzzles,runs,min_us,median_us,"
+              . "p99_us,puzzles_per_sec,nodes,propagations", "CSV header");
+is(scalar @rows, 8, "one row per engine and branching");
+my $number = qr/\d+(?:\.\d+)?/;
+is(scalar(grep { /^\Q$PUZZLES\E,all,\w+,[\w-]+,10,1,(?:$number,){4}\d+,\d+$/ } @rows),
+   8, "rows are well formed");
+
+# the counters agree with what solvesudoku reports for the same work
+my ($dlx) = grep { /,dlx,/ } @rows;
+my $nodes = (split /,/, $dlx)[10];
+`$SOLVER -B -e dlx -v $PUZZLES 2>&1 >/dev/null` =~ /, (\d+) nodes/;
+is($nodes, $1, "dlx node count matches solvesudoku");
+
+my @perPuzzle = split /\n/, `$BENCH -n 2 -p -e propagate $PUZZLES 2>/dev/null`;
+is(scalar @perPuzzle, 11, "-p gives a row per puzzle");
+is(system("$BENCH -n 0 $PUZZLES >/dev/null 2>&1") >> 8, 1, "-n 0 is refused");
@@ -0,0 +1,42 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use Test::More tests => 10;
+
+my $SOLVER="./solvesudoku";
+my $PUZZLES="testpuzzles.txt";
+
+# a plain build has no counters to report
+`make -B $SOLVER >/dev/null 2>&1`;
+ok((!$? and -e "$SOLVER"), "$SOLVER built");
+my $refused = `echo | $SOLVER -S line 2>&1`;
+is($? >> 8, 1, "plain build refuses -S");
+like($refused, qr/STATS=1/, "and says how to get it");
+
+`make -B STATS=1 $SOLVER >/dev/null 2>&1`;
+ok((!$? and -e "$SOLVER"), "$SOLVER built with STATS=1");
+
+my $puzzle = `sed -n 1p $PUZZLES`;
+chomp $puzzle;
+my $line = `echo $puzzle | $SOLVER -b mrv -S line 2>&1 >/dev/null`;
+like($line, qr/^stats: 1 puzzles, \d+ nodes, \d+ guesses, \d+ backtracks, max depth \d+, \d+ deduced, \d+ propagations, \d+ checks, deduce [\d.e-]+ ms, search [\d.e-]+ ms$/,
+     "-S line");
+
+my $json = `echo $puzzle | $SOLVER -e propagate -S json 2>&1 >/dev/null`;
+like($json, qr/^\{"puzzles":1,"nodes":\d+,"guesses":\d+,"backtracks":\d+,"max_depth":\d+,"deduced":\d+,"propagations":\d+,"checks":\d+,"deduce_ms":[\d.e-]+,"search_ms":[\d.e-]+\}$/,
+     "-S json");
+my ($nodes, $guesses, $backtracks) =
+    $json =~ /"nodes":(\d+),"guesses":(\d+),"backtracks":(\d+)/;
+is($guesses, $nodes - 1, "one guess per node below the root");
+ok($backtracks <= $guesses, "no more backtracks than guesses");
+
+# batch mode totals agree with the plain -v counters
+my $batch = `$SOLVER -B -e dlx -v -S json $PUZZLES 2>&1 >/dev/null`;
+my ($vnodes) = $batch =~ /, (\d+) nodes/;
+like($batch, qr/\{"puzzles":10,"nodes":$vnodes,/, "batch totals");
+
+# leave a plain build behind for the other scripts
+`make -B >/dev/null 2>&1`;
+ok(!$?, "plain rebuild");
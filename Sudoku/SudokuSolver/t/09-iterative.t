@@ -0,0 +1,41 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use Test::More tests => 8;
+
+my $SOLVER="./solvesudoku";
+my $CHECKER="./sudokucheck.pl";
+my $PUZZLES="testpuzzles.txt";
+
+ok(-e "$SOLVER", "$SOLVER exists");
+
+# the same search as backtrack, so the same solutions and node counts
+foreach my $branch ("first", "mrv") {
+    my $iterative = `$SOLVER -B -v -e iterative -b $branch $PUZZLES 2>&1`;
+    my $recursive = `$SOLVER -B -v -e backtrack -b $branch $PUZZLES 2>&1`;
+    s/ in [\d.e-]+ s \([\d.e-]+ puzzles\/sec\)// for $iterative, $recursive;
+    is($iterative, $recursive, "-b $branch: same solutions and nodes as backtrack");
+}
+
+my $counts = `$SOLVER -B -c -e iterative -b mrv $PUZZLES 2>/dev/null`;
+is($counts, `$SOLVER -B -c -e backtrack -b mrv $PUZZLES 2>/dev/null`,
+   "counts like backtrack");
+
+# resuming after each solution enumerates them all
+my $out = `echo '................' | $SOLVER -s 2 -c -l 1000 -e iterative`;
+like($out, qr/^288 solutions  nodes: \d+$/m, "288 4x4 grids");
+
+# split into slices handed round the pool
+my $puzzle = `sed -n 1p hard.txt`;
+chomp $puzzle;
+$out = `echo '$puzzle' | $SOLVER -e iterative -j 4 | $CHECKER`;
+ok(!$?, "-j 4 solves a hard puzzle");
+$out = `echo '$puzzle' | $SOLVER -e iterative -b mrv -j 4 | $CHECKER`;
+ok(!$?, "-j 4 -b mrv solves a hard puzzle");
+
+my $big = `sed -n 2p testpuzzles16x16.txt`;
+chomp $big;
+$out = `echo '$big' | $SOLVER -s 4 -e iterative -b mrv`;
+like($out, qr/^(?:[1-9A-G] (?:\| )?){16}$/m, "16x16");
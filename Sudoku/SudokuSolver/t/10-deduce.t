@@ -0,0 +1,52 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use Test::More tests => 16;
+
+my $SOLVER="./solvesudoku";
+my $PUZZLES="testpuzzles.txt";
+my $HARD="hard.txt";
+
+ok(-e "$SOLVER", "$SOLVER exists");
+
+# the test puzzles are proper, so any sound pass leaves the same answer
+my $plain = `$SOLVER -B -e dlx -D none $PUZZLES 2>/dev/null`;
+foreach my $passes ("locked", "naked", "hidden", "xwing", "all") {
+    is(`$SOLVER -B -e dlx -D $passes $PUZZLES 2>/dev/null`, $plain,
+       "-D $passes: same solutions");
+}
+
+# each pass finds something to strike in hard.txt
+sub eliminated {
+    my ($passes) = @_;
+    my $out = `$SOLVER -B -e dlx -v -D $passes $HARD 2>&1 >/dev/null`;
+    my %struck = $out =~ /(\w+) (\d+)(?=,|$)/mg;
+    my ($nodes) = $out =~ /, (\d+) nodes/;
+    return ($nodes, \%struck);
+}
+foreach my $pass ("locked", "naked", "hidden", "xwing") {
+    my ($nodes, $struck) = eliminated($pass);
+    ok($struck->{$pass} > 0, "$pass strikes marks");
+}
+my ($none, $zero) = eliminated("none");
+is(scalar(grep { $_ > 0 } values %$zero), 0, "-D none strikes nothing");
+my ($all) = eliminated("all");
+ok($all < $none, "passes shrink the search ($all < $none nodes)");
+
+my $out = `echo '$plain' | head -1 | $SOLVER -v 2>&1 >/dev/null`;
+like($out, qr/^eliminated:  locked \d+  naked \d+  hidden \d+  xwing \d+$/m,
+     "-v reports eliminations");
+
+is(system("$SOLVER -D bogus < /dev/null >/dev/null 2>&1") >> 8, 1,
+   "unknown pass refused");
+
+# the passes hold for every solution, not just a unique one, so
+# counts on boards with several stay the same
+foreach my $size (2, 4) {
+    my $file = $size == 2 ? "testpuzzles4x4.txt" : "testpuzzles16x16.txt";
+    my @with = map { (split)[0] } `$SOLVER -B -c -l 100000 -e dlx -s $size $file 2>/dev/null`;
+    my @without = map { (split)[0] } `$SOLVER -B -c -l 100000 -e dlx -s $size -D none $file 2>/dev/null`;
+    is("@with", "@without", "-s $size: same solution counts");
+}
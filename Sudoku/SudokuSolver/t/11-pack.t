@@ -0,0 +1,58 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use Test::More tests => 13;
+
+my $SOLVER="./solvesudoku";
+my $PACK="./sudokupack";
+my $PUZZLES="testpuzzles.txt";
+my $BIG="testpuzzles16x16.txt";
+my $dir = tempdir(CLEANUP => 1);
+
+`make $PACK >/dev/null 2>&1`;
+ok((!$? and -e "$PACK"), "$PACK built");
+
+# 16 byte header, then 41 bytes per 9x9 grid
+`$PACK -o $dir/t.pzl $PUZZLES 2>/dev/null`;
+is(-s "$dir/t.pzl", 16 + 10 * 41, "packed size");
+
+my $text = join "", map { s/0/./gr } grep { /\S/ } `cat $PUZZLES`;
+is(`$PACK -u $dir/t.pzl`, $text, "unpacks to the same puzzles");
+
+is(`$SOLVER -B -e dlx $dir/t.pzl 2>/dev/null`, `$SOLVER -B -e dlx $PUZZLES 2>/dev/null`,
+   "batch mode solves a packed file");
+is(`$SOLVER -B -c -e propagate $dir/t.pzl 2>/dev/null`,
+   `$SOLVER -B -c -e propagate $PUZZLES 2>/dev/null`, "and counts one");
+
+# a byte per cell for 16x16, and the size comes from the header
+`$PACK -s 4 -o $dir/big.pzl $BIG 2>/dev/null`;
+is(-s "$dir/big.pzl", 16 + 6 * 256, "16x16 packed size");
+is(`$PACK -u $dir/big.pzl`, `cat $BIG`, "16x16 round trip");
+is(`$SOLVER -B -e dlx $dir/big.pzl 2>/dev/null`, `$SOLVER -B -s 4 -e dlx $BIG 2>/dev/null`,
+   "16x16 solved without -s");
+
+# a header promising more grids than the file holds
+`head -c 400 $dir/t.pzl > $dir/short.pzl`;
+my $out = `$SOLVER -B $dir/short.pzl 2>&1`;
+isnt($? >> 8, 0, "truncated file refused");
+like($out, qr/truncated/, "and says why");
+
+# a damaged record: the first two cells of the second grid read 15
+open(my $fh, "+<", "$dir/t.pzl") or die;
+binmode $fh;
+seek($fh, 16 + 41, 0);
+print $fh "\xff";
+close($fh);
+my @lines = grep { /\S/ } `cat $PUZZLES`;
+splice(@lines, 1, 1);
+open($fh, ">", "$dir/rest.txt") or die;
+print $fh @lines;
+close($fh);
+$out = `$PACK -u $dir/t.pzl 2>$dir/err.txt`;
+is($out, join("", map { s/0/./gr } @lines), "unpacking skips a damaged record");
+like(`cat $dir/err.txt`, qr/^record 2: bogus puzzle!$/m, "and reports it");
+is(`$SOLVER -B -e dlx $dir/t.pzl 2>/dev/null`, `$SOLVER -B -e dlx $dir/rest.txt 2>/dev/null`,
+   "batch mode skips it too");
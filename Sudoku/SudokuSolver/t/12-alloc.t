@@ -0,0 +1,42 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use Test::More tests => 9;
+
+my $COUNTER="./allocount";
+my $PACK="./sudokupack";
+my $FEW="testpuzzles.txt";
+my $MANY="simple.txt";
+my $dir = tempdir(CLEANUP => 1);
+
+`make $COUNTER $PACK >/dev/null 2>&1`;
+ok((!$? and -e "$COUNTER"), "$COUNTER built");
+
+# the allocations of a single threaded batch run, or undef if it
+# failed or never reported them
+sub allocations {
+    my ($args) = @_;
+    my ($n) = `$COUNTER -B $args 2>&1 >/dev/null` =~ /^allocations: (\d+)$/m;
+    return $? ? undef : $n;
+}
+
+# which should not grow with the number of puzzles
+sub sameAllocations {
+    my ($many, $few, $name) = @_;
+    my ($m, $f) = (allocations($many), allocations($few));
+    ok((defined $m and defined $f and $m == $f), $name)
+        or diag("allocations: " . ($m // "none") . " vs " . ($f // "none"));
+}
+
+for my $engine (qw(backtrack propagate dlx iterative lanes learn)) {
+    sameAllocations("-e $engine $MANY", "-e $engine $FEW",
+                    "$engine allocates nothing per puzzle");
+}
+sameAllocations("-c -e dlx $MANY", "-c -e dlx $FEW", "nor does counting");
+
+`$PACK -o $dir/few.pzl $FEW 2>/dev/null`;
+`$PACK -o $dir/many.pzl $MANY 2>/dev/null`;
+sameAllocations("$dir/many.pzl", "$dir/few.pzl", "nor does a packed file");
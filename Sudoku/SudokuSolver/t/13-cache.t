@@ -0,0 +1,78 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use Test::More tests => 12;
+
+my $SOLVER="./solvesudoku";
+my $PUZZLES="hard.txt";
+my $dir = tempdir(CLEANUP => 1);
+
+`make $SOLVER >/dev/null 2>&1`;
+ok((!$? and -e "$SOLVER"), "$SOLVER built");
+
+# each puzzle transposed, with its bands reversed and its digits
+# relabelled: a different puzzle of the same symmetry class
+my @puzzles = grep { length == 81 } map { s/\s+//gr } `cat $PUZZLES`;
+my @variants = map {
+    my @c = split //;
+    join "", map {
+        my ($r, $c) = (int($_ / 9), $_ % 9);
+        my $v = $c[((2 - int($c / 3)) * 3 + $c % 3) * 9 + $r];
+        $v =~ /[1-9]/ ? 10 - $v : $v;
+    } 0 .. 80;
+} @puzzles;
+open my $fh, ">", "$dir/variants.txt" or die;
+print $fh map { "$_\n" } @variants;
+close $fh;
+open $fh, ">", "$dir/both.txt" or die;
+print $fh map { "$_\n" } @puzzles, @variants;
+close $fh;
+
+sub hits {
+    my ($err) = @_;
+    return $err =~ /(\d+) cache hits/ ? $1 : -1;
+}
+
+my $plain = `$SOLVER -B -e dlx $dir/both.txt 2>/dev/null`;
+my $err = `$SOLVER -B -e dlx -C 1000 $dir/both.txt 2>&1 >$dir/out.txt`;
+is(`cat $dir/out.txt`, $plain, "cached solutions match");
+cmp_ok(hits($err), ">=", scalar @variants, "every variant is a hit");
+is(`$SOLVER -B -e dlx -C 1000 -j 2 $dir/both.txt 2>/dev/null`, $plain,
+   "and with two threads");
+
+# the cache file outlives the run and serves another one
+$err = `$SOLVER -B -e dlx --cache-file $dir/cache $PUZZLES 2>&1 >/dev/null`;
+is(`wc -l < $dir/cache` + 0, @puzzles - hits($err), "one cache line per class");
+$err = `$SOLVER -B -e dlx --cache-file $dir/cache $dir/variants.txt 2>&1 >$dir/out.txt`;
+is(hits($err), scalar @variants, "a saved cache serves a later run");
+is(`cat $dir/out.txt`, `$SOLVER -B -e dlx $dir/variants.txt 2>/dev/null`,
+   "with the same solutions");
+
+# the least recently used solutions go first
+`$SOLVER -B -e dlx -C 3 --cache-file $dir/small $PUZZLES 2>/dev/null`;
+is(`wc -l < $dir/small` + 0, 3, "the cache stays within -C");
+
+`echo garbage > $dir/bad`;
+`$SOLVER -B -e dlx --cache-file $dir/bad $PUZZLES 2>/dev/null`;
+isnt($? >> 8, 0, "a bad cache file is refused");
+
+# the first entry with one open cell of its solution changed, so a
+# digit repeats
+my ($canon, $solution) = split ' ', `head -1 $dir/cache`;
+my $open = index($canon, ".");
+substr($solution, $open, 1) = substr($solution, $open, 1) % 9 + 1;
+`(echo $canon $solution; tail -n +2 $dir/cache) > $dir/corrupt`;
+`$SOLVER -B -e dlx --cache-file $dir/corrupt $PUZZLES 2>/dev/null`;
+isnt($? >> 8, 0, "a cache entry whose solution is wrong is refused");
+
+# a full grid with a repeated digit, 16 of its cells blanked: unsolved,
+# and nothing goes into the cache
+my $clash = "994582136268931745315476982689715324432869571157243869821657493943128657576394218";
+substr($clash, 20, 16) = "." x 16;
+`echo $clash > $dir/clash.txt`;
+is(`$SOLVER -B -C 10 --cache-file $dir/clash.cache $dir/clash.txt 2>/dev/null`, "$clash\n",
+   "clashing givens are not solved through the cache");
+is(-s "$dir/clash.cache" // 0, 0, "nor cached");
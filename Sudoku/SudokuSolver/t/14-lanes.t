@@ -0,0 +1,48 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use Test::More tests => 9;
+
+my $SOLVER="./solvesudoku";
+my $PUZZLES="simple.txt";
+my $dir = tempdir(CLEANUP => 1);
+
+`make $SOLVER >/dev/null 2>&1`;
+ok((!$? and -e "$SOLVER"), "$SOLVER built");
+
+my $plain = `$SOLVER -B $PUZZLES 2>/dev/null`;
+my $err = `$SOLVER -B -e lanes $PUZZLES 2>&1 >$dir/out.txt`;
+is(`cat $dir/out.txt`, $plain, "same solutions as backtrack");
+
+# the lanes finish exactly the puzzles singles alone solve: those the
+# propagate engine counts at one node with no deduction passes
+my $singles = grep { /^1 1$/ } `$SOLVER -B -c -D none -e propagate $PUZZLES 2>/dev/null`;
+my ($lanes) = $err =~ /(\d+) solved in lanes/;
+is($lanes, $singles, "lanes solve the singles-only puzzles");
+
+is(`SUDOKU_LANES=sse2 $SOLVER -B -e lanes $PUZZLES 2>/dev/null`, $plain,
+   "and so do 128-bit lanes");
+is(`$SOLVER -B -e lanes -j 2 $PUZZLES 2>/dev/null`, $plain, "and two threads");
+
+for my $size ([2, "testpuzzles4x4.txt"], [4, "testpuzzles16x16.txt"]) {
+    my ($s, $file) = @$size;
+    is(`$SOLVER -B -s $s -b mrv -e lanes $file 2>/dev/null`,
+       `$SOLVER -B -s $s -b mrv $file 2>/dev/null`, "-s $s matches backtrack");
+}
+
+# a clash in the givens leaves a lane inconsistent, not solved
+my $first = `head -1 $PUZZLES`;
+chomp $first;
+`echo 9${\ substr($first, 1)} > $dir/clash.txt`;
+$err = `$SOLVER -B -e lanes $dir/clash.txt 2>&1 >/dev/null`;
+like($err, qr/1 unsolved, 0 solved in lanes/, "clashing givens are not solved");
+
+# clashing givens among good puzzles are echoed without a search
+my $pair = "11" . "." x 79;
+`(head -3 $PUZZLES; echo $pair; sed -n 4,20p $PUZZLES; echo $pair) > $dir/mixed.txt`;
+$err = `timeout 20 $SOLVER -B -e lanes $dir/mixed.txt 2>&1 >$dir/out.txt`;
+ok((`cat $dir/out.txt` eq `$SOLVER -B $dir/mixed.txt 2>/dev/null` and $err =~ /2 unsolved/),
+   "clashing givens never reach the fallback search");
@@ -0,0 +1,77 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use IO::Socket::UNIX;
+use Socket qw(SOCK_STREAM);
+use Test::More tests => 11;
+
+my $SOLVER="./solvesudoku";
+my $CLIENT="./sudokuclient";
+my $PUZZLES="simple.txt";
+my $dir = tempdir(CLEANUP => 1);
+my $sock = "$dir/solver.sock";
+
+`make $SOLVER $CLIENT >/dev/null 2>&1`;
+ok((!$? and -e "$SOLVER" and -e "$CLIENT"), "$SOLVER and $CLIENT built");
+
+# starts a server in the background, waiting until it is listening
+sub serve {
+    my ($err, @args) = @_;
+    my $pid = fork();
+    if ($pid == 0) {
+        open(STDERR, ">", $err) or die;
+        exec($SOLVER, "--serve", $sock, @args) or die;
+    }
+    for (1 .. 100) {
+        last if -s $err and `cat $err` =~ /^serving on/;
+        select(undef, undef, undef, 0.05);
+    }
+    return $pid;
+}
+
+my $pid = serve("$dir/server.err", "-e", "dlx", "-j", "2");
+my $plain = `$SOLVER -B -e dlx $PUZZLES 2>/dev/null`;
+is(`$CLIENT $sock $PUZZLES 2>/dev/null`, $plain, "same solutions as -B");
+is(`$CLIENT -p 32 -r 3 $sock $PUZZLES 2>/dev/null`, $plain x 3,
+   "pipelined and repeated, in order");
+`($CLIENT -p 8 $sock $PUZZLES >$dir/a.out & $CLIENT -p 8 $sock $PUZZLES >$dir/b.out; wait) 2>/dev/null`;
+is(`cat $dir/a.out $dir/b.out`, $plain x 2, "two clients at once");
+
+# a clash in the givens comes back unsolved, echoed as -B does
+my $first = `head -1 $PUZZLES`;
+chomp $first;
+my $clash = "9" . substr($first, 1);
+`printf 'bogus\\n$clash\\n' > $dir/odd.txt`;
+my $err = `$CLIENT $sock $dir/odd.txt 2>&1 >$dir/odd.out`;
+like($err, qr/^line 1: bogus puzzle$/m, "bogus lines are reported");
+is(`cat $dir/odd.out`, "$clash\n", "unsolvable puzzles are echoed");
+
+# a frame too long to be a puzzle gets an error and a hang-up
+my $raw = IO::Socket::UNIX->new(Type => SOCK_STREAM, Peer => $sock);
+print $raw pack("N", 1 << 20);
+my $reply = "";
+1 while sysread($raw, $reply, 64, length $reply);
+is($reply, pack("N", 10) . "Ebad frame", "oversized frames are refused");
+
+like(`$SOLVER --serve $sock 2>&1`, qr/another server is listening/,
+     "a live socket is not taken over");
+
+# stopping with a client still connected
+my $idle = IO::Socket::UNIX->new(Type => SOCK_STREAM, Peer => $sock);
+kill("TERM", $pid);
+waitpid($pid, 0);
+ok((!$? and !-e $sock), "SIGTERM stops the server and removes the socket");
+like(`cat $dir/server.err`, qr/puzzles on 8 connections/, "server summary");
+
+# a socket left behind by a killed server is reused
+$pid = serve("$dir/killed.err");
+kill("KILL", $pid);
+waitpid($pid, 0);
+$pid = serve("$dir/again.err");
+is(`$CLIENT $sock $PUZZLES 2>/dev/null`, `$SOLVER -B $PUZZLES 2>/dev/null`,
+   "a stale socket is taken over");
+kill("TERM", $pid);
+waitpid($pid, 0);
@@ -0,0 +1,57 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use Test::More tests => 11;
+
+my $SOLVER="./solvesudoku";
+my $PUZZLES="simple.txt";
+my $dir = tempdir(CLEANUP => 1);
+
+`make $SOLVER >/dev/null 2>&1`;
+ok((!$? and -e "$SOLVER"), "$SOLVER built");
+
+`$SOLVER -B $PUZZLES > $dir/solved.txt 2>/dev/null`;
+`paste -d' ' $PUZZLES $dir/solved.txt > $dir/pairs.txt`;
+my $err = `$SOLVER -V $dir/pairs.txt 2>&1`;
+ok((!$? and $err =~ /^(\d+) pairs in .*, 0 bad$/m and $1 > 0), "-B solutions pass");
+
+for my $size ([2, "testpuzzles4x4.txt"], [4, "testpuzzles16x16.txt"]) {
+    my ($s, $file) = @$size;
+    `$SOLVER -B -s $s -b mrv $file 2>/dev/null | paste -d' ' $file - > $dir/pairs$s.txt`;
+    `$SOLVER -V -s $s $dir/pairs$s.txt 2>/dev/null`;
+    ok(!$?, "-s $s solutions pass");
+}
+
+# one broken copy of the first pair per kind of fault
+my ($puzzle, $solution) = split ' ', `head -1 $dir/pairs.txt`;
+my $given = index($puzzle, (grep { $_ ne "." && $_ ne "0" } split //, $puzzle)[0]);
+my $open = index($puzzle, ".") >= 0 ? index($puzzle, ".") : index($puzzle, "0");
+my %broken;
+($broken{given} = $solution) =~ s/^(.{$given})(.)/$1 . ($2 % 9 + 1)/e;
+($broken{empty} = $solution) =~ s/^(.{$open})./$1./;
+($broken{bogus} = $solution) =~ s/^(.{$open})./$1x/;
+# swapping two digits of a row leaves the row whole but not the columns
+($broken{column} = $solution) =~ s/^(.)(.)/$2$1/;
+open(my $fh, ">", "$dir/bad.txt") or die;
+print $fh "$puzzle $broken{$_}\n" for qw(given empty bogus);
+print $fh "." x 81, " $broken{column}\n";
+print $fh "$puzzle ${\ substr($solution, 1)}\r\n\n$puzzle\t$solution\r\n";
+close($fh);
+
+my $out = `$SOLVER -V $dir/bad.txt 2>$dir/err.txt`;
+is($? >> 8, 2, "exit status 2 when a pair fails");
+my @lines = split /\n/, $out;
+like($lines[0], qr/^line 1: given changed at row \d+, column \d+$/, "a changed given");
+like($lines[1], qr/^line 2: empty cell at row \d+, column \d+$/, "an empty cell");
+like($lines[2], qr/^line 3: bogus character at/, "a bogus character");
+like($lines[3], qr/^line 4: column \d+ repeats a digit$/, "a repeated digit");
+like("$lines[4]|" . `cat $dir/err.txt`, qr/^line 5: bogus pair!\|6 pairs in .*, 5 bad$/m,
+     "short lines are bogus, blank lines and CRLF are fine");
+
+# NUL bytes are not line-end noise: the pair is bogus
+`printf '%s %s\\0\\0\\n' $puzzle $solution > $dir/nul.txt`;
+like(`$SOLVER -V $dir/nul.txt 2>/dev/null`, qr/^line 1: bogus pair!$/m,
+     "trailing NULs are not stripped");
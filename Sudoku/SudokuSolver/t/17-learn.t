@@ -0,0 +1,50 @@
+#!/usr/bin/env perl
+
+use strict;
+use warnings;
+use utf8;
+use File::Temp qw(tempdir);
+use Test::More tests => 10;
+
+my $SOLVER="./solvesudoku";
+my $dir = tempdir(CLEANUP => 1);
+
+`make $SOLVER >/dev/null 2>&1`;
+ok((!$? and -e "$SOLVER"), "$SOLVER built");
+
+for my $file (qw(simple.txt hard.txt)) {
+    is(`$SOLVER -B -e learn $file 2>/dev/null`, `$SOLVER -B $file 2>/dev/null`,
+       "same solutions as backtrack on $file");
+}
+is(`$SOLVER -B -e learn -b mrv hard.txt 2>/dev/null`, `$SOLVER -B hard.txt 2>/dev/null`,
+   "and with mrv branching");
+
+# these have more than one solution, and a new digit order finds
+# another, so check them instead
+for my $size ([2, "testpuzzles4x4.txt"], [4, "testpuzzles16x16.txt"]) {
+    my ($s, $file) = @$size;
+    `$SOLVER -B -s $s -b mrv -e learn $file 2>/dev/null | paste -d' ' $file - > $dir/pairs$s.txt`;
+    `$SOLVER -V -s $s $dir/pairs$s.txt 2>/dev/null`;
+    ok(!$?, "-s $s solutions pass -V");
+}
+
+# the hard puzzles take restarts, and the nogoods prune something
+my $err = `$SOLVER -B -v -e learn hard.txt 2>&1 >/dev/null`;
+ok(($err =~ /(\d+) restarts, (\d+) nogood prunes/ and $1 > 0 and $2 > 0),
+   "restarts and nogood prunes are reported");
+
+# a puzzle with no solution still ends, after every state is refuted
+my $first = `head -1 simple.txt`;
+chomp $first;
+my $clash = "9" . substr($first, 1);
+`echo $clash > $dir/clash.txt`;
+is(`$SOLVER -B -e learn $dir/clash.txt 2>/dev/null`, "$clash\n",
+   "unsolvable puzzles are echoed");
+
+like(`head -1 hard.txt | $SOLVER -j 2 -e learn 2>&1 >/dev/null`, qr/^-j ignored/m,
+     "-j on a single puzzle says it is ignored");
+
+# a clash in the givens is never learned, so it is refused up front
+my $pair = "11" . "." x 79;
+`echo $pair | timeout 20 $SOLVER -e learn > /dev/null 2>&1`;
+isnt($? >> 8, 124, "a single puzzle with clashing givens ends");